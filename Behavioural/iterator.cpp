@@ -50,85 +50,242 @@ Real-World Example:
 Summary:
 The Iterator pattern provides a standard way to traverse a collection of objects without exposing the underlying implementation. It's particularly useful for abstracting the traversal logic, making the code flexible and easy to maintain.
 
+Contiguous Storage (CompactLibrary):
+Library keeps every Book as its own heap node behind a std::shared_ptr, and BookIterator::next() returns that
+shared_ptr by value, which is an atomic increment and decrement per element. CompactLibrary stores the catalog
+contiguously instead:
+- Each book is a fixed-size BookRecord (offsets and lengths), held by value in one array.
+- All titles and authors live back to back in one string arena.
+- BookTable is a non-owning view over the records and the arena. It is a C++20 std::ranges::random_access_range
+  whose iterator yields BookView values: two std::string_views into the arena, with no allocation or refcount.
+Book's getters now return const references instead of std::string copies.
+
+Parallel and Chunked Iteration:
+An Iterator hands out one element at a time, so a scan over the whole catalog runs on one core. Both libraries can
+now be split:
+- createChunkedIterators(k) splits the collection into k contiguous, non-overlapping parts of nearly equal size.
+  Library returns k BookIterators over index ranges; CompactLibrary returns k BookTable ranges.
+- BookTable::split(k) does the same on any table, and slice(first, last) cuts out one part.
+- parallelForEach(table, threads, fn) runs fn on every book from several threads. The table is cut into small
+  chunks that idle threads claim from a shared atomic counter, so a slow chunk does not hold the others back.
+fn is called concurrently and must be thread-safe.
+
+Indexed Iteration:
+Finding the books of one author used to mean walking every element and comparing strings. Library now keeps two
+secondary indexes next to the books:
+- An author index: a hash map from author to the positions of that author's books, in insertion order.
+- A title index: the positions of all books sorted by title, so a title prefix is a contiguous run found by binary search.
+addBook updates the author index directly and appends to the title index; the first prefix lookup after one or more
+adds sorts only the new title entries and merges them into the sorted part in one pass, so bulk loading stays linear
+in the number of books added instead of shifting the index on every call. addBooks(batch) adds a batch in one call. createIterator(AuthorFilter{...}) and createIterator(TitlePrefixFilter{...})
+return an IndexedBookIterator that walks only the matching positions, so a lookup costs O(matches) (plus O(log N) for
+a prefix) instead of O(N). Adding books while an indexed iterator is in use may change what it returns.
+
+Memory-Mapped Catalogs (MappedLibrary):
+Catalogs that are too large to build in memory are stored in a compact binary file: a CatalogHeader, then every
+title and author back to back, then the BookRecord array (the same layout CompactLibrary uses in memory).
+- CatalogWriter streams a catalog to disk: text is written as books are added, and only the fixed-size records are
+  buffered until finish() writes them and the real header. saveCatalog(library, path) writes a CompactLibrary.
+- MappedLibrary(path) mmaps the file read-only and checks only the header, so opening takes the same time for any
+  catalog size. books() is the same BookTable range, and its BookViews point straight into the mapped pages.
+  Each record is checked against the text arena when it is read, so a corrupt record throws instead of reading
+  past the mapping.
+- Pages are faulted in only when a book is read, so the resident set holds just the pages that were touched.
+  adviseSequential() asks the kernel to read ahead before a full scan.
+- The Iterator interface returns std::shared_ptr<Book>, which cannot point into a mapping, so mapped catalogs are
+  read through BookTable. Errors from the OS are thrown as std::system_error, and a bad header or an out-of-range
+  record as std::runtime_error.
+
 */
+#include "iterator.h"
+
+#include <chrono>
+#include <filesystem>
 #include <iostream>
-#include <vector>
-#include <memory>
-#include <string>
 
-// Book class (elements in the collection)
-class Book {
-private:
+// Scans a large catalog through the virtual hasNext()/next() protocol and through the contiguous range
+void runScanBenchmark() {
+    const std::size_t bookCount = 10'000'000;
+
+    Library library;
+    CompactLibrary compact;
+    compact.reserve(bookCount, bookCount * 24);
     std::string title;
     std::string author;
+    for (std::size_t i = 0; i < bookCount; ++i) {
+        title = "Title " + std::to_string(i);
+        author = "Author " + std::to_string(i % 100'000);
+        library.addBook(title, author);
+        compact.addBook(title, author);
+    }
 
-public:
-    Book(const std::string& t, const std::string& a) : title(t), author(a) {}
+    std::size_t classicTotal = 0;
+    auto begin = std::chrono::steady_clock::now();
+    std::unique_ptr<Iterator> iterator = library.createIterator();
+    while (iterator->hasNext()) {
+        std::shared_ptr<Book> book = iterator->next();
+        classicTotal += book->getTitle().size() + book->getAuthor().size();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double classicMs = std::chrono::duration<double, std::milli>(end - begin).count();
 
-    // Getter methods to retrieve book details
-    std::string getTitle() const {
-        return title;
+    std::size_t compactTotal = 0;
+    begin = std::chrono::steady_clock::now();
+    for (BookView book : compact) {
+        compactTotal += book.title.size() + book.author.size();
     }
+    end = std::chrono::steady_clock::now();
+    double compactMs = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    std::cout << "\nScanning " << bookCount << " books:\n";
+    std::cout << "Iterator hasNext()/next(): " << classicMs << " ms\n";
+    std::cout << "CompactLibrary range:      " << compactMs << " ms"
+              << (classicTotal == compactTotal ? "" : "  (MISMATCH)") << '\n';
+}
 
-    std::string getAuthor() const {
-        return author;
+// Search scan over a large catalog with 1 to 32 threads
+void runParallelScanBenchmark() {
+    const std::size_t bookCount = 10'000'000;
+    CompactLibrary compact;
+    compact.reserve(bookCount, bookCount * 24);
+    for (std::size_t i = 0; i < bookCount; ++i) {
+        compact.addBook("Title " + std::to_string(i), "Author " + std::to_string(i % 100'000));
     }
-};
 
-// Iterator Interface (defines methods for traversing a collection)
-class Iterator {
-public:
-    virtual bool hasNext() const = 0;  // Check if there are more elements
-    virtual std::shared_ptr<Book> next() = 0;  // Return the next element
-    virtual ~Iterator() = default;
-};
+    std::cout << "\nParallel search over " << bookCount << " books (" << std::thread::hardware_concurrency()
+              << " hardware threads):\n";
+    std::cout << "threads\tms\tmatches\n";
+    for (unsigned threads = 1; threads <= 32; threads *= 2) {
+        std::atomic<std::size_t> matches{0};
+        auto begin = std::chrono::steady_clock::now();
+        parallelForEach(compact.books(), threads, [&matches](BookView book) {
+            if (book.title.find("42") != std::string_view::npos) {
+                matches.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        auto end = std::chrono::steady_clock::now();
+        std::cout << threads << '\t' << std::chrono::duration<double, std::milli>(end - begin).count() << '\t'
+                  << matches.load() << '\n';
+    }
+}
 
-// ConcreteIterator (implements the Iterator interface for a vector of Books)
-class BookIterator : public Iterator {
-private:
-    const std::vector<std::shared_ptr<Book>>& books;  // Reference to the book collection
-    size_t index;  // Current position in the collection
+// Looks up books by author and by title prefix with a full scan and with the indexes
+void runIndexBenchmark() {
+    const size_t bookCount = 1'000'000;
+    const size_t authorCount = 50'000;
+    const int queries = 20;
 
-public:
-    BookIterator(const std::vector<std::shared_ptr<Book>>& b) : books(b), index(0) {}
+    Library library;
+    std::vector<std::pair<std::string, std::string>> batch;
+    batch.reserve(bookCount);
+    for (size_t i = 0; i < bookCount; ++i) {
+        batch.emplace_back("Title " + std::to_string(i), "Author " + std::to_string(i % authorCount));
+    }
+    auto begin = std::chrono::steady_clock::now();
+    library.addBooks(batch);
+    library.createIterator(TitlePrefixFilter{""});  // First prefix lookup sorts the pending title entries
+    auto end = std::chrono::steady_clock::now();
+    double loadMs = std::chrono::duration<double, std::milli>(end - begin).count();
 
-    // Check if there are more books in the collection
-    bool hasNext() const override {
-        return index < books.size();
+    std::vector<std::string> authors;
+    std::vector<std::string> prefixes;
+    for (int q = 0; q < queries; ++q) {
+        authors.push_back("Author " + std::to_string(q * 2'477 % authorCount));
+        prefixes.push_back("Title " + std::to_string(q * 3'331 % 10'000));
     }
 
-    // Return the next book and increment the index
-    std::shared_ptr<Book> next() override {
-        if (hasNext()) {
-            return books[index++];
+    size_t scanMatches = 0;
+    begin = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; ++q) {
+        std::unique_ptr<Iterator> iterator = library.createIterator();
+        while (iterator->hasNext()) {
+            std::shared_ptr<Book> book = iterator->next();
+            scanMatches += book->getAuthor() == authors[q];
+            scanMatches += book->getTitle().starts_with(prefixes[q]);
         }
-        return nullptr;
     }
-};
+    end = std::chrono::steady_clock::now();
+    double scanMs = std::chrono::duration<double, std::milli>(end - begin).count();
 
-// Aggregate Interface (defines a method to create an iterator)
-class BookCollection {
-public:
-    virtual std::unique_ptr<Iterator> createIterator() const = 0;
-    virtual ~BookCollection() = default;
-};
+    size_t indexMatches = 0;
+    begin = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; ++q) {
+        for (auto iterator = library.createIterator(AuthorFilter{authors[q]}); iterator->hasNext(); iterator->next()) {
+            ++indexMatches;
+        }
+        for (auto iterator = library.createIterator(TitlePrefixFilter{prefixes[q]}); iterator->hasNext(); iterator->next()) {
+            ++indexMatches;
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    double indexMs = std::chrono::duration<double, std::milli>(end - begin).count();
 
-// ConcreteAggregate (implements the collection and provides an iterator)
-class Library : public BookCollection {
-private:
-    std::vector<std::shared_ptr<Book>> books;
+    std::cout << "\nAuthor and title-prefix lookups over " << bookCount << " books (" << queries << " of each):\n";
+    std::cout << "addBooks and title sort:   " << loadMs << " ms\n";
+    std::cout << "Full scan:                 " << scanMs << " ms\n";
+    std::cout << "Indexed iterators:         " << indexMs << " ms"
+              << (scanMatches == indexMatches ? "" : "  (MISMATCH)") << '\n';
+}
 
-public:
-    // Add a new book to the collection
-    void addBook(const std::string& title, const std::string& author) {
-        books.push_back(std::make_shared<Book>(title, author));
+// Resident set size of this process in bytes (Linux /proc/self/statm)
+std::size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t totalPages = 0;
+    std::size_t residentPages = 0;
+    statm >> totalPages >> residentPages;
+    return residentPages * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+// Streams a large catalog to disk, then measures opening it, one point lookup and a full scan through the mapping
+void runMappedCatalogBenchmark() {
+    const std::size_t bookCount = 5'000'000;
+    const std::string path = (std::filesystem::temp_directory_path() / "iterator_catalog.bin").string();
+
+    auto begin = std::chrono::steady_clock::now();
+    {
+        CatalogWriter writer(path);
+        for (std::size_t i = 0; i < bookCount; ++i) {
+            writer.addBook("Title " + std::to_string(i), "Author " + std::to_string(i % 100'000));
+        }
+        writer.finish();
     }
+    auto end = std::chrono::steady_clock::now();
+    double writeMs = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    std::size_t rssBefore = residentBytes();
+    begin = std::chrono::steady_clock::now();
+    MappedLibrary mapped(path);
+    end = std::chrono::steady_clock::now();
+    double openUs = std::chrono::duration<double, std::micro>(end - begin).count();
+    std::size_t rssOpen = residentBytes();
+
+    begin = std::chrono::steady_clock::now();
+    BookView middle = mapped[bookCount / 2];
+    std::size_t lookupBytes = middle.title.size() + middle.author.size();
+    end = std::chrono::steady_clock::now();
+    double lookupUs = std::chrono::duration<double, std::micro>(end - begin).count();
+    std::size_t rssLookup = residentBytes();
 
-    // Create and return an iterator for the book collection
-    std::unique_ptr<Iterator> createIterator() const override {
-        return std::make_unique<BookIterator>(books);
+    mapped.adviseSequential();
+    std::size_t total = 0;
+    begin = std::chrono::steady_clock::now();
+    for (BookView book : mapped) {
+        total += book.title.size() + book.author.size();
     }
-};
+    end = std::chrono::steady_clock::now();
+    double scanMs = std::chrono::duration<double, std::milli>(end - begin).count();
+    std::size_t rssScan = residentBytes();
+
+    std::cout << "\nMemory-mapped catalog of " << bookCount << " books (" << std::filesystem::file_size(path) / (1024 * 1024)
+              << " MiB):\n";
+    std::cout << "Stream to disk:  " << writeMs << " ms\n";
+    std::cout << "Open:            " << openUs << " us, resident +" << (rssOpen - rssBefore) / 1024 << " KiB\n";
+    std::cout << "One lookup:      " << lookupUs << " us, resident +" << (rssLookup - rssBefore) / 1024 << " KiB ("
+              << lookupBytes << " bytes read)\n";
+    std::cout << "Full scan:       " << scanMs << " ms, resident +" << (rssScan - rssBefore) / (1024 * 1024) << " MiB ("
+              << total << " bytes read)\n";
+    std::filesystem::remove(path);
+}
 
 // Client code
 int main() {
@@ -148,5 +305,58 @@ int main() {
         std::cout << "Title: " << book->getTitle() << ", Author: " << book->getAuthor() << std::endl;
     }
 
+    // Contiguous library iterated with a range-for and the standard range algorithms
+    CompactLibrary compact;
+    compact.addBook("The Catcher in the Rye", "J.D. Salinger");
+    compact.addBook("To Kill a Mockingbird", "Harper Lee");
+    compact.addBook("1984", "George Orwell");
+
+    std::cout << "\nBooks in the compact library:\n";
+    for (BookView book : compact) {
+        std::cout << "Title: " << book.getTitle() << ", Author: " << book.getAuthor() << std::endl;
+    }
+    auto orwell = std::ranges::find(compact.books(), std::string_view("George Orwell"), &BookView::author);
+    std::cout << "Found by author: " << (*orwell).title << std::endl;
+
+    // Split the libraries into parts that separate threads can walk
+    std::vector<std::unique_ptr<Iterator>> parts = library.createChunkedIterators(2);
+    std::cout << "\nFirst book of each part:\n";
+    for (auto& part : parts) {
+        if (part->hasNext()) {
+            std::cout << "Title: " << part->next()->getTitle() << std::endl;
+        }
+    }
+    std::atomic<std::size_t> titleBytes{0};
+    parallelForEach(compact.books(), 2, [&titleBytes](BookView book) { titleBytes += book.title.size(); });
+    std::cout << "Title bytes counted in parallel: " << titleBytes.load() << std::endl;
+
+    // Walk only the books matching a filter, answered from the library's indexes
+    library.addBooks({{"Animal Farm", "George Orwell"}, {"Go Set a Watchman", "Harper Lee"}});
+    std::cout << "\nBooks by George Orwell:\n";
+    for (auto matches = library.createIterator(AuthorFilter{"George Orwell"}); matches->hasNext();) {
+        std::cout << "Title: " << matches->next()->getTitle() << std::endl;
+    }
+    std::cout << "Titles starting with \"T\":\n";
+    for (auto matches = library.createIterator(TitlePrefixFilter{"T"}); matches->hasNext();) {
+        std::cout << "Title: " << matches->next()->getTitle() << std::endl;
+    }
+
+    // Save the compact library in the catalog format and read it back through a memory mapping
+    const std::string catalogPath = (std::filesystem::temp_directory_path() / "iterator_demo_catalog.bin").string();
+    saveCatalog(compact, catalogPath);
+    {
+        MappedLibrary mapped(catalogPath);
+        std::cout << "\nBooks in the mapped catalog:\n";
+        for (BookView book : mapped) {
+            std::cout << "Title: " << book.getTitle() << ", Author: " << book.getAuthor() << std::endl;
+        }
+    }
+    std::filesystem::remove(catalogPath);
+
+    runScanBenchmark();
+    runParallelScanBenchmark();
+    runIndexBenchmark();
+    runMappedCatalogBenchmark();
+
     return 0;
 }
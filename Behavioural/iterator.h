@@ -0,0 +1,571 @@
+// Iterator pattern classes. iterator.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+// Book class (elements in the collection)
+class Book {
+private:
+    std::string title;
+    std::string author;
+
+public:
+    Book(const std::string& t, const std::string& a) : title(t), author(a) {}
+
+    // Getter methods to retrieve book details
+    const std::string& getTitle() const {
+        return title;
+    }
+
+    const std::string& getAuthor() const {
+        return author;
+    }
+};
+
+// Iterator Interface (defines methods for traversing a collection)
+class Iterator {
+public:
+    virtual bool hasNext() const = 0;  // Check if there are more elements
+    virtual std::shared_ptr<Book> next() = 0;  // Return the next element
+    virtual ~Iterator() = default;
+};
+
+// ConcreteIterator (implements the Iterator interface for a vector of Books)
+class BookIterator : public Iterator {
+private:
+    const std::vector<std::shared_ptr<Book>>& books;  // Reference to the book collection
+    size_t index;  // Current position in the collection
+    size_t last;  // One past the last position this iterator visits
+
+public:
+    BookIterator(const std::vector<std::shared_ptr<Book>>& b) : books(b), index(0), last(b.size()) {}
+
+    // Iterates only over positions [first, end) of the collection
+    BookIterator(const std::vector<std::shared_ptr<Book>>& b, size_t first, size_t end)
+        : books(b), index(first), last(std::min(end, b.size())) {}
+
+    // Check if there are more books in the collection
+    bool hasNext() const override {
+        return index < last;
+    }
+
+    // Return the next book and increment the index
+    std::shared_ptr<Book> next() override {
+        if (hasNext()) {
+            return books[index++];
+        }
+        return nullptr;
+    }
+};
+
+// ConcreteIterator over a precomputed list of positions (the matches of an index lookup)
+class IndexedBookIterator : public Iterator {
+private:
+    const std::vector<std::shared_ptr<Book>>& books;  // Reference to the book collection
+    const std::vector<size_t>& positions;  // Index entries pointing into books
+    size_t index;  // Current entry in positions
+    size_t last;  // One past the last entry this iterator visits
+
+public:
+    IndexedBookIterator(const std::vector<std::shared_ptr<Book>>& b, const std::vector<size_t>& p, size_t first, size_t end)
+        : books(b), positions(p), index(first), last(std::min(end, p.size())) {}
+
+    // Check if there are more matching books
+    bool hasNext() const override {
+        return index < last;
+    }
+
+    // Return the next matching book and advance to the following match
+    std::shared_ptr<Book> next() override {
+        if (hasNext()) {
+            return books[positions[index++]];
+        }
+        return nullptr;
+    }
+};
+
+// Filters accepted by Library::createIterator; each one is answered from an index
+struct AuthorFilter {
+    std::string_view author;  // Exact author name
+};
+
+struct TitlePrefixFilter {
+    std::string_view prefix;  // Titles starting with this prefix
+};
+
+// Aggregate Interface (defines a method to create an iterator)
+class BookCollection {
+public:
+    virtual std::unique_ptr<Iterator> createIterator() const = 0;
+    virtual ~BookCollection() = default;
+};
+
+// ConcreteAggregate (implements the collection and provides an iterator)
+class Library : public BookCollection {
+private:
+    // Lets the author index be searched with a std::string_view without building a std::string
+    struct AuthorHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view author) const {
+            return std::hash<std::string_view>{}(author);
+        }
+    };
+
+    std::vector<std::shared_ptr<Book>> books;
+    // Author -> positions of that author's books, in insertion order
+    std::unordered_map<std::string, std::vector<size_t>, AuthorHash, std::equal_to<>> authorIndex;
+    // Positions of all books sorted by title (ties keep insertion order); entries past titleSorted
+    // were appended since the last prefix lookup and are merged in by mergePendingTitles()
+    mutable std::vector<size_t> titleIndex;
+    mutable size_t titleSorted = 0;
+    mutable std::mutex titleMutex;
+
+    bool titleBefore(size_t lhs, size_t rhs) const {
+        const std::string& left = books[lhs]->getTitle();
+        const std::string& right = books[rhs]->getTitle();
+        return left < right || (left == right && lhs < rhs);
+    }
+
+    // Sort the titles added since the last lookup and merge them into the sorted part of the index
+    void mergePendingTitles() const {
+        if (titleSorted == titleIndex.size()) {
+            return;
+        }
+        auto before = [this](size_t lhs, size_t rhs) { return titleBefore(lhs, rhs); };
+        auto sortedEnd = titleIndex.begin() + static_cast<std::ptrdiff_t>(titleSorted);
+        std::sort(sortedEnd, titleIndex.end(), before);
+        std::inplace_merge(titleIndex.begin(), sortedEnd, titleIndex.end(), before);
+        titleSorted = titleIndex.size();
+    }
+
+public:
+    // Add a new book to the collection and record it in both indexes
+    void addBook(const std::string& title, const std::string& author) {
+        size_t position = books.size();
+        books.push_back(std::make_shared<Book>(title, author));
+        auto entry = authorIndex.find(std::string_view(author));
+        if (entry == authorIndex.end()) {
+            entry = authorIndex.emplace(author, std::vector<size_t>{}).first;
+        }
+        entry->second.push_back(position);
+        titleIndex.push_back(position);
+    }
+
+    // Add many books at once
+    void addBooks(const std::vector<std::pair<std::string, std::string>>& batch) {
+        books.reserve(books.size() + batch.size());
+        titleIndex.reserve(titleIndex.size() + batch.size());
+        for (const auto& [title, author] : batch) {
+            addBook(title, author);
+        }
+    }
+
+    // Create and return an iterator for the book collection
+    std::unique_ptr<Iterator> createIterator() const override {
+        return std::make_unique<BookIterator>(books);
+    }
+
+    // Create an iterator over the books of one author, looked up in the author index
+    std::unique_ptr<Iterator> createIterator(AuthorFilter filter) const {
+        static const std::vector<size_t> noMatches;
+        auto entry = authorIndex.find(filter.author);
+        const std::vector<size_t>& matches = entry != authorIndex.end() ? entry->second : noMatches;
+        return std::make_unique<IndexedBookIterator>(books, matches, 0, matches.size());
+    }
+
+    // Create an iterator over the books whose title starts with a prefix, in title order
+    std::unique_ptr<Iterator> createIterator(TitlePrefixFilter filter) const {
+        std::lock_guard<std::mutex> lock(titleMutex);
+        mergePendingTitles();
+        auto first = std::partition_point(titleIndex.begin(), titleIndex.end(), [&](size_t position) {
+            return std::string_view(books[position]->getTitle()) < filter.prefix;
+        });
+        auto last = std::partition_point(first, titleIndex.end(), [&](size_t position) {
+            return std::string_view(books[position]->getTitle()).starts_with(filter.prefix);
+        });
+        return std::make_unique<IndexedBookIterator>(books, titleIndex, first - titleIndex.begin(), last - titleIndex.begin());
+    }
+
+    // Create k iterators over contiguous, non-overlapping parts of the collection (for parallel scans)
+    std::vector<std::unique_ptr<Iterator>> createChunkedIterators(size_t k) const {
+        k = std::max<size_t>(k, 1);
+        std::vector<std::unique_ptr<Iterator>> iterators;
+        iterators.reserve(k);
+        for (size_t part = 0; part < k; ++part) {
+            iterators.push_back(std::make_unique<BookIterator>(books, books.size() * part / k, books.size() * (part + 1) / k));
+        }
+        return iterators;
+    }
+};
+
+// Fixed-size description of one book; the text lives in the owning library's string arena
+struct BookRecord {
+    std::uint64_t titleOffset;
+    std::uint64_t authorOffset;
+    std::uint32_t titleLength;
+    std::uint32_t authorLength;
+};
+
+// A book as seen through a BookTable: views into the arena, valid as long as the library is
+struct BookView {
+    std::string_view title;
+    std::string_view author;
+
+    std::string_view getTitle() const { return title; }
+    std::string_view getAuthor() const { return author; }
+};
+
+// Non-owning, random-access range over contiguous book records. Records are checked against the arena as they are
+// read, since a mapped catalog's offsets come straight from the file.
+class BookTable {
+private:
+    const BookRecord* records = nullptr;
+    std::size_t count = 0;
+    const char* arena = nullptr;
+    std::size_t arenaBytes = 0;
+
+    // The record's text, or "corrupt book catalog" if it does not lie inside the arena
+    static std::string_view text(const char* textArena, std::size_t textBytes, std::uint64_t offset,
+                                 std::uint32_t length) {
+        if (offset > textBytes || length > textBytes - offset) {
+            throw std::runtime_error("corrupt book catalog: record outside the text arena");
+        }
+        return std::string_view(textArena + offset, length);
+    }
+
+public:
+    class iterator {
+    private:
+        const BookRecord* record = nullptr;
+        const char* arena = nullptr;
+        std::size_t arenaBytes = 0;
+
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::input_iterator_tag;  // reference is a prvalue, so only input for C++17 algorithms
+        using value_type = BookView;
+        using difference_type = std::ptrdiff_t;
+        using reference = BookView;
+
+        iterator() = default;
+        iterator(const BookRecord* current, const char* textArena, std::size_t textBytes)
+            : record(current), arena(textArena), arenaBytes(textBytes) {}
+
+        BookView operator*() const {
+            return BookView{text(arena, arenaBytes, record->titleOffset, record->titleLength),
+                            text(arena, arenaBytes, record->authorOffset, record->authorLength)};
+        }
+        BookView operator[](difference_type n) const { return *(*this + n); }
+
+        iterator& operator++() { ++record; return *this; }
+        iterator operator++(int) { iterator old = *this; ++record; return old; }
+        iterator& operator--() { --record; return *this; }
+        iterator operator--(int) { iterator old = *this; --record; return old; }
+        iterator& operator+=(difference_type n) { record += n; return *this; }
+        iterator& operator-=(difference_type n) { record -= n; return *this; }
+
+        friend iterator operator+(iterator it, difference_type n) { return it += n; }
+        friend iterator operator+(difference_type n, iterator it) { return it += n; }
+        friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const iterator& a, const iterator& b) { return a.record - b.record; }
+        friend bool operator==(const iterator& a, const iterator& b) { return a.record == b.record; }
+        friend auto operator<=>(const iterator& a, const iterator& b) { return a.record <=> b.record; }
+    };
+
+    BookTable() = default;
+    BookTable(const BookRecord* first, std::size_t size, const char* textArena, std::size_t textBytes)
+        : records(first), count(size), arena(textArena), arenaBytes(textBytes) {}
+
+    iterator begin() const { return iterator(records, arena, arenaBytes); }
+    iterator end() const { return iterator(records + count, arena, arenaBytes); }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    BookView operator[](std::size_t index) const { return begin()[static_cast<std::ptrdiff_t>(index)]; }
+
+    // Books [first, last) of this table
+    BookTable slice(std::size_t first, std::size_t last) const {
+        last = std::min(last, count);
+        first = std::min(first, last);
+        return BookTable(records + first, last - first, arena, arenaBytes);
+    }
+
+    // k contiguous parts of nearly equal size that together cover the table
+    std::vector<BookTable> split(std::size_t k) const {
+        k = std::max<std::size_t>(k, 1);
+        std::vector<BookTable> parts;
+        parts.reserve(k);
+        for (std::size_t part = 0; part < k; ++part) {
+            parts.push_back(slice(count * part / k, count * (part + 1) / k));
+        }
+        return parts;
+    }
+};
+
+// BookTable only points into the library, so iterators stay valid after the table object itself is gone
+template <>
+inline constexpr bool std::ranges::enable_borrowed_range<BookTable> = true;
+
+static_assert(std::random_access_iterator<BookTable::iterator>);
+static_assert(std::ranges::random_access_range<BookTable> && std::ranges::sized_range<BookTable>);
+
+// Contiguous library: books by value in one array, titles and authors in one string arena
+class CompactLibrary {
+private:
+    std::vector<BookRecord> records;
+    std::string arena;
+
+public:
+    void reserve(std::size_t books, std::size_t textBytes) {
+        records.reserve(books);
+        arena.reserve(textBytes);
+    }
+
+    void addBook(std::string_view title, std::string_view author) {
+        BookRecord record{arena.size(), arena.size() + title.size(),
+                          static_cast<std::uint32_t>(title.size()), static_cast<std::uint32_t>(author.size())};
+        arena.append(title);
+        arena.append(author);
+        records.push_back(record);
+    }
+
+    // Random-access range over the books; invalidated by addBook()
+    BookTable books() const { return BookTable(records.data(), records.size(), arena.data(), arena.size()); }
+
+    BookTable::iterator begin() const { return books().begin(); }
+    BookTable::iterator end() const { return books().end(); }
+    std::size_t size() const { return records.size(); }
+    BookView operator[](std::size_t index) const { return books()[index]; }
+
+    // k ranges over contiguous, non-overlapping parts of the library (for parallel scans)
+    std::vector<BookTable> createChunkedIterators(std::size_t k) const { return books().split(k); }
+};
+
+// Fixed header at the start of a catalog file. Layout: header, string arena, padding to 8 bytes, BookRecord array
+struct CatalogHeader {
+    char magic[8];
+    std::uint64_t bookCount;
+    std::uint64_t arenaOffset;
+    std::uint64_t arenaBytes;
+    std::uint64_t recordsOffset;
+};
+
+inline constexpr char kCatalogMagic[8] = {'B', 'O', 'O', 'K', 'C', 'A', 'T', '1'};
+
+// Streams a catalog to disk: text is written as books are added, only the 24-byte records are buffered until finish()
+class CatalogWriter {
+private:
+    std::ofstream out;
+    std::vector<BookRecord> records;
+    std::uint64_t arenaBytes = 0;
+
+public:
+    explicit CatalogWriter(const std::string& path) : out(path, std::ios::binary | std::ios::trunc) {
+        if (!out) {
+            throw std::runtime_error("cannot create catalog " + path);
+        }
+        CatalogHeader placeholder{};  // Zero magic until finish(), so an unfinished file is rejected on open
+        out.write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+    }
+
+    void addBook(std::string_view title, std::string_view author) {
+        records.push_back(BookRecord{arenaBytes, arenaBytes + title.size(),
+                                     static_cast<std::uint32_t>(title.size()), static_cast<std::uint32_t>(author.size())});
+        out.write(title.data(), static_cast<std::streamsize>(title.size()));
+        out.write(author.data(), static_cast<std::streamsize>(author.size()));
+        arenaBytes += title.size() + author.size();
+    }
+
+    // Write the record array and the real header; the file is not readable before this is called
+    void finish() {
+        std::uint64_t recordsOffset = (sizeof(CatalogHeader) + arenaBytes + alignof(BookRecord) - 1) / alignof(BookRecord) * alignof(BookRecord);
+        static constexpr char padding[alignof(BookRecord)] = {};
+        out.write(padding, static_cast<std::streamsize>(recordsOffset - sizeof(CatalogHeader) - arenaBytes));
+        out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(BookRecord)));
+
+        CatalogHeader header{};
+        std::memcpy(header.magic, kCatalogMagic, sizeof(kCatalogMagic));
+        header.bookCount = records.size();
+        header.arenaOffset = sizeof(CatalogHeader);
+        header.arenaBytes = arenaBytes;
+        header.recordsOffset = recordsOffset;
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+        if (!out) {
+            throw std::runtime_error("failed to write catalog");
+        }
+    }
+};
+
+// Write a CompactLibrary in the on-disk catalog format
+inline void saveCatalog(const CompactLibrary& library, const std::string& path) {
+    CatalogWriter writer(path);
+    for (BookView book : library) {
+        writer.addBook(book.title, book.author);
+    }
+    writer.finish();
+}
+
+// Read-only library backed by a memory-mapped catalog file. Opening maps the file and checks the header only, so
+// startup cost does not depend on the catalog size; pages are faulted in, and records bounds-checked, when a book is
+// first read.
+class MappedLibrary {
+private:
+    const char* base = nullptr;
+    std::size_t length = 0;
+    BookTable table;
+
+public:
+    explicit MappedLibrary(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot open catalog " + path);
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "cannot stat catalog " + path);
+        }
+        length = static_cast<std::size_t>(info.st_size);
+        if (length < sizeof(CatalogHeader)) {
+            ::close(fd);
+            throw std::runtime_error("not a book catalog: " + path);
+        }
+        void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        int error = errno;
+        ::close(fd);  // The mapping keeps the file referenced
+        if (mapping == MAP_FAILED) {
+            throw std::system_error(error, std::generic_category(), "cannot map catalog " + path);
+        }
+        base = static_cast<const char*>(mapping);
+
+        CatalogHeader header;
+        std::memcpy(&header, base, sizeof(header));
+        bool valid = std::memcmp(header.magic, kCatalogMagic, sizeof(kCatalogMagic)) == 0
+                     && header.arenaOffset <= length && header.arenaBytes <= length - header.arenaOffset
+                     && header.recordsOffset % alignof(BookRecord) == 0 && header.recordsOffset <= length
+                     && header.bookCount <= (length - header.recordsOffset) / sizeof(BookRecord);
+        if (!valid) {
+            ::munmap(mapping, length);
+            throw std::runtime_error("corrupt book catalog: " + path);
+        }
+        table = BookTable(reinterpret_cast<const BookRecord*>(base + header.recordsOffset),
+                          static_cast<std::size_t>(header.bookCount), base + header.arenaOffset,
+                          static_cast<std::size_t>(header.arenaBytes));
+    }
+
+    MappedLibrary(const MappedLibrary&) = delete;
+    MappedLibrary& operator=(const MappedLibrary&) = delete;
+
+    MappedLibrary(MappedLibrary&& other) noexcept
+        : base(std::exchange(other.base, nullptr)), length(std::exchange(other.length, 0)), table(std::exchange(other.table, BookTable())) {}
+
+    MappedLibrary& operator=(MappedLibrary&& other) noexcept {
+        if (this != &other) {
+            if (base) {
+                ::munmap(const_cast<char*>(base), length);
+            }
+            base = std::exchange(other.base, nullptr);
+            length = std::exchange(other.length, 0);
+            table = std::exchange(other.table, BookTable());
+        }
+        return *this;
+    }
+
+    ~MappedLibrary() {
+        if (base) {
+            ::munmap(const_cast<char*>(base), length);
+        }
+    }
+
+    // Tell the kernel a full scan follows, so it reads ahead aggressively (the default suits point lookups)
+    void adviseSequential() const {
+        ::madvise(const_cast<char*>(base), length, MADV_SEQUENTIAL);
+    }
+
+    // Random-access range of string_views straight into the mapped pages; valid while the library is alive
+    BookTable books() const { return table; }
+
+    BookTable::iterator begin() const { return table.begin(); }
+    BookTable::iterator end() const { return table.end(); }
+    std::size_t size() const { return table.size(); }
+    BookView operator[](std::size_t index) const { return table[index]; }
+
+    // k ranges over contiguous, non-overlapping parts of the library (for parallel scans)
+    std::vector<BookTable> createChunkedIterators(std::size_t k) const { return table.split(k); }
+};
+
+// Calls fn(BookView) for every book from `threads` threads; chunks are claimed dynamically for load balance.
+// If fn throws, no further chunks are claimed, all threads are joined, and the first exception is rethrown.
+template <typename Fn>
+void parallelForEach(const BookTable& table, unsigned threads, Fn fn, std::size_t chunkSize = 16 * 1024) {
+    threads = std::max(1u, threads);
+    chunkSize = std::max<std::size_t>(chunkSize, 1);
+    std::size_t chunkCount = (table.size() + chunkSize - 1) / chunkSize;
+    std::atomic<std::size_t> nextChunk{0};
+    std::mutex errorMutex;
+    std::exception_ptr firstError;
+
+    auto work = [&]() {
+        try {
+            for (std::size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed); chunk < chunkCount;
+                 chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) {
+                for (BookView book : table.slice(chunk * chunkSize, (chunk + 1) * chunkSize)) {
+                    fn(book);
+                }
+            }
+        } catch (...) {
+            nextChunk.store(chunkCount, std::memory_order_relaxed);  // The other threads stop after their chunk
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!firstError) {
+                firstError = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    helpers.reserve(threads - 1);
+    try {
+        for (unsigned t = 1; t < threads; ++t) {
+            helpers.emplace_back(work);
+        }
+    } catch (...) {
+        nextChunk.store(chunkCount, std::memory_order_relaxed);  // Could not start a thread: stop the started ones
+        for (auto& helper : helpers) {
+            helper.join();
+        }
+        throw;
+    }
+    work();  // The calling thread takes part as well
+    for (auto& helper : helpers) {
+        helper.join();
+    }
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
@@ -52,75 +52,222 @@ The Observer pattern is a powerful pattern for implementing distributed event-ha
 It promotes loose coupling between the subject and its observers, enabling dynamic addition and removal of observers,
 and ensuring that when the subject's state changes, all observers are notified and can react accordingly.
 
+Concurrent Subject (ConcurrentWeatherStation):
+WeatherStation's plain std::vector is not synchronized, so observers cannot come and go on other threads while
+notifications fire. ConcurrentWeatherStation uses copy-on-write snapshots instead:
+- The observer list is an immutable snapshot published through std::atomic<std::shared_ptr<const Snapshot>>.
+  notifyObservers() loads the current snapshot and walks it; it never takes the subscription mutex.
+- subscribe() copies the snapshot, appends the observer and publishes the copy (writers serialize on a mutex).
+- subscribe() returns a Subscription token. unsubscribe(token) is O(1): it flips the entry's active flag, and
+  notifications skip inactive entries. Dead entries are compacted out once they outnumber the live ones,
+  which keeps unsubscribe amortized O(1).
+- A notification that already loaded the old snapshot may still deliver one last update to an observer that is being
+  unsubscribed; the snapshot keeps that observer alive until the notification is done.
+
+Asynchronous Dispatch (AsyncObserver):
+notifyObservers() calls every update() synchronously, so one slow display stalls the producer. AsyncObserver is an
+Observer that wraps another observer and delivers to it from its own worker thread:
+- Each AsyncObserver owns a bounded single-producer/single-consumer ring buffer, so update() on the producer side is
+  a couple of atomic operations and never blocks.
+- ConflationPolicy::DeliverAll queues every value and counts a drop when the ring is full.
+- ConflationPolicy::LatestValueWins keeps only the newest value; values overwritten before the worker picks them up
+  are counted as conflated. The value and its pending flag share one atomic word that both sides swap, so each
+  value is delivered at most once. This suits fast-moving readings such as temperature.
+- stats() exposes the current queue depth and the delivered/dropped counters.
+Because the ring is single-producer, each AsyncObserver must be notified from one thread at a time.
+
+Topic-Filtered, Batched Publication (WeatherHub):
+Every observer of a WeatherStation receives every value, one virtual update(float) per value, even when it only
+cares about one station or a temperature threshold. WeatherHub moves that filtering into the subject:
+- Observer gains an update(std::span<const float>) batch overload (by default it calls update(float) per value).
+- Subscriptions name a topic (a StationId, or kAnyStation) and either a TemperatureRange or an arbitrary predicate.
+- publish(station, readings) takes a batch. Subscribers with the same range share one RangeGroup, so each distinct
+  range is filtered once per batch with a branchless compaction loop. A group whose range covers the whole batch
+  gets the batch as is, and a group whose range misses it entirely is skipped without looking at the values.
+- Each subscriber then receives at most one update(span) per batch, and only if something matched.
+WeatherHub is single-threaded like WeatherStation; combine it with the techniques above for concurrent use.
+
 */
+#include "observer.h"
+
+#include <chrono>
 #include <iostream>
-#include <vector>
-#include <memory>
-#include <algorithm>
 
-// Observer Interface
-class Observer {
+// Observer that only counts updates (no I/O), used to measure the notification path itself
+class CountingDisplay : public Observer {
+private:
+    std::atomic<std::uint64_t> updates{0};
+
 public:
-    virtual void update(float temperature) = 0;  // Update method to be called when subject's state changes
-    virtual ~Observer() = default;
+    using Observer::update;
+
+    void update(float) override {
+        updates.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const {
+        return updates.load(std::memory_order_relaxed);
+    }
 };
 
-// Subject Interface (Observable)
-class Subject {
+// Subscriber that counts readings inside its range; update(float) filters itself, update(span) trusts the subject
+class ThresholdCounter : public Observer {
+private:
+    TemperatureRange range;
+    std::uint64_t matches = 0;
+
 public:
-    virtual void addObserver(std::shared_ptr<Observer> observer) = 0;
-    virtual void removeObserver(std::shared_ptr<Observer> observer) = 0;
-    virtual void notifyObservers() = 0;
-    virtual ~Subject() = default;
+    explicit ThresholdCounter(TemperatureRange interested) : range(interested) {}
+
+    void update(float temperature) override {
+        if (temperature >= range.min && temperature <= range.max) {
+            ++matches;
+        }
+    }
+
+    void update(std::span<const float> temperatures) override {
+        matches += temperatures.size();
+    }
+
+    std::uint64_t count() const { return matches; }
 };
 
-// ConcreteSubject (WeatherStation)
-class WeatherStation : public Subject {
+// Observer that takes about the given time per update, like a display doing blocking I/O
+class SlowDisplay : public Observer {
 private:
-    float temperature;  // Current temperature (the state)
-    std::vector<std::shared_ptr<Observer>> observers;  // List of observers
+    std::chrono::microseconds cost;
 
 public:
-    // Add an observer to the list
-    void addObserver(std::shared_ptr<Observer> observer) override {
-        observers.push_back(observer);
+    using Observer::update;
+
+    explicit SlowDisplay(std::chrono::microseconds perUpdate) : cost(perUpdate) {}
+
+    void update(float) override {
+        auto until = std::chrono::steady_clock::now() + cost;
+        while (std::chrono::steady_clock::now() < until) {
+        }
     }
+};
 
-    // Remove an observer from the list
-    void removeObserver(std::shared_ptr<Observer> observer) override {
-        observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+// Notifications per second while another thread keeps subscribing and unsubscribing
+void runConcurrentNotifyBenchmark() {
+    const std::size_t notifications = 1'000'000;
+    ConcurrentWeatherStation station;
+    std::vector<std::shared_ptr<CountingDisplay>> stable;
+    for (int i = 0; i < 8; ++i) {
+        stable.push_back(std::make_shared<CountingDisplay>());
+        station.subscribe(stable.back());
     }
 
-    // Notify all observers of the state change
-    void notifyObservers() override {
-        for (const auto& observer : observers) {
-            observer->update(temperature);
+    std::atomic<bool> done{false};
+    std::uint64_t churn = 0;
+    std::thread subscriber([&]() {
+        auto transient = std::make_shared<CountingDisplay>();
+        while (!done.load(std::memory_order_acquire)) {
+            auto token = station.subscribe(transient);
+            station.unsubscribe(token);
+            ++churn;
         }
+    });
+
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < notifications; ++i) {
+        station.setTemperature(static_cast<float>(i % 40));
     }
+    auto end = std::chrono::steady_clock::now();
+    done.store(true, std::memory_order_release);
+    subscriber.join();
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    std::cout << "\nConcurrentWeatherStation: " << static_cast<double>(notifications) / seconds
+              << " notifications/s to " << stable.size() << " observers with "
+              << churn << " concurrent subscribe/unsubscribe pairs\n";
+    std::cout << "Each stable observer received " << stable.front()->count() << " updates\n";
+}
 
-    // Change the temperature and notify the observers
-    void setTemperature(float newTemperature) {
-        std::cout << "WeatherStation: New temperature is " << newTemperature << " degrees." << std::endl;
-        temperature = newTemperature;
-        notifyObservers();  // Notify all observers of the change
+// Fan-out cost of one second of readings: per-value broadcast to every observer vs. filtered batches
+void runFanOutBenchmark() {
+    const std::size_t readingsPerSecond = 1'000;
+    const std::size_t batchSize = 100;
+    const std::size_t distinctRanges = 16;
+
+    std::vector<float> readings(readingsPerSecond);
+    for (std::size_t i = 0; i < readings.size(); ++i) {
+        readings[i] = static_cast<float>((i * 37) % 50);  // 0..49 degrees
     }
-};
 
-// ConcreteObserver (PhoneDisplay)
-class PhoneDisplay : public Observer {
-public:
-    void update(float temperature) override {
-        std::cout << "PhoneDisplay: The temperature is now " << temperature << " degrees." << std::endl;
+    std::cout << "\nFan-out of " << readingsPerSecond << " readings:\n";
+    std::cout << "subscribers\tbroadcast ms\thub ms\tvirtual calls (broadcast / hub)\n";
+    for (std::size_t subscribers : {100, 1'000, 10'000}) {
+        std::vector<std::shared_ptr<ThresholdCounter>> naive;
+        std::vector<std::shared_ptr<ThresholdCounter>> filtered;
+        WeatherHub hub;
+        for (std::size_t i = 0; i < subscribers; ++i) {
+            // Thresholds such as "above 40 degrees", 16 distinct ones across all subscribers
+            TemperatureRange range{static_cast<float>(35 + i % distinctRanges), std::numeric_limits<float>::infinity()};
+            naive.push_back(std::make_shared<ThresholdCounter>(range));
+            filtered.push_back(std::make_shared<ThresholdCounter>(range));
+            hub.subscribe(filtered.back(), 1, range);
+        }
+
+        // Broadcast, as WeatherStation::notifyObservers() does: every observer sees every value
+        std::vector<std::shared_ptr<Observer>> observers(naive.begin(), naive.end());
+        auto begin = std::chrono::steady_clock::now();
+        for (float reading : readings) {
+            for (const auto& observer : observers) {
+                observer->update(reading);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        double broadcastMs = std::chrono::duration<double, std::milli>(end - begin).count();
+
+        begin = std::chrono::steady_clock::now();
+        for (std::size_t offset = 0; offset < readings.size(); offset += batchSize) {
+            hub.publish(1, std::span<const float>(readings).subspan(offset, batchSize));
+        }
+        end = std::chrono::steady_clock::now();
+        double hubMs = std::chrono::duration<double, std::milli>(end - begin).count();
+
+        bool same = true;
+        for (std::size_t i = 0; i < subscribers; ++i) {
+            same = same && naive[i]->count() == filtered[i]->count();
+        }
+        std::cout << subscribers << "\t\t" << broadcastMs << "\t\t" << hubMs << '\t'
+                  << subscribers * readingsPerSecond << " / " << hub.deliveredBatches()
+                  << (same ? "" : "  (MISMATCH)") << '\n';
     }
-};
+}
 
-// ConcreteObserver (WindowDisplay)
-class WindowDisplay : public Observer {
-public:
-    void update(float temperature) override {
-        std::cout << "WindowDisplay: The temperature is now " << temperature << " degrees." << std::endl;
+// How long the producer is stalled per update with a slow observer, synchronous vs asynchronous dispatch
+void runAsyncDispatchBenchmark() {
+    const std::size_t updates = 10'000;
+    auto slow = std::make_shared<SlowDisplay>(std::chrono::microseconds(20));
+
+    auto measure = [&](const std::shared_ptr<Observer>& observer) {
+        WeatherStation station;
+        station.addObserver(observer);
+        auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < updates; ++i) {
+            station.notifyObservers();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - begin).count() / static_cast<double>(updates);
+    };
+
+    std::cout << "\nProducer cost per update with a 20us observer:\n";
+    std::cout << "synchronous:       " << measure(slow) << " ns\n";
+
+    auto all = std::make_shared<AsyncObserver>(slow, ConflationPolicy::DeliverAll, 1024);
+    auto latestOnly = std::make_shared<AsyncObserver>(slow, ConflationPolicy::LatestValueWins);
+    std::cout << "async deliver-all: " << measure(all) << " ns\n";
+    std::cout << "async latest-wins: " << measure(latestOnly) << " ns\n";
+
+    for (const auto& [name, observer] : {std::pair{"deliver-all", all}, std::pair{"latest-wins", latestOnly}}) {
+        ObserverQueueStats stats = observer->stats();
+        std::cout << name << ": depth " << stats.depth << ", delivered " << stats.delivered
+                  << ", dropped " << stats.dropped << '\n';
     }
-};
+}
 
 // Client code
 int main() {
@@ -141,5 +288,36 @@ int main() {
     // Simulate another temperature change
     weatherStation->setTemperature(30.0f);
 
+    // Concurrent subject: observers may subscribe and unsubscribe from any thread
+    ConcurrentWeatherStation concurrentStation;
+    ConcurrentWeatherStation::Subscription phone = concurrentStation.subscribe(phoneDisplay);
+    concurrentStation.subscribe(windowDisplay);
+    concurrentStation.setTemperature(27.0f);
+    concurrentStation.unsubscribe(phone);  // O(1), only the window display is notified from now on
+    concurrentStation.setTemperature(28.0f);
+
+    // Asynchronous dispatch: the window display is updated from its own worker thread
+    {
+        WeatherStation asyncStation;
+        auto asyncWindow = std::make_shared<AsyncObserver>(windowDisplay, ConflationPolicy::DeliverAll);
+        asyncStation.addObserver(asyncWindow);
+        asyncStation.setTemperature(31.0f);
+    }  // Destroying the AsyncObserver delivers what is still queued and stops its worker
+
+    // Topic and range subscriptions: the hub only calls observers with readings they asked for
+    WeatherHub hub;
+    const StationId airport = 1;
+    const StationId harbour = 2;
+    hub.subscribe(phoneDisplay, airport);                            // Everything from the airport
+    hub.subscribe(windowDisplay, kAnyStation, TemperatureRange{30.0f, 50.0f});  // Heat warnings from anywhere
+    std::vector<float> harbourReadings = {22.0f, 31.5f, 24.0f};
+    hub.publish(harbour, harbourReadings);  // Only the window display gets 31.5
+    hub.publish(airport, 18.0f);            // Only the phone display gets 18
+
+    flushEvents();  // The benchmarks print to std::cout directly
+    runConcurrentNotifyBenchmark();
+    runAsyncDispatchBenchmark();
+    runFanOutBenchmark();
+
     return 0;
 }
@@ -0,0 +1,507 @@
+// Observer pattern classes. observer.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include "instrumentation.h"
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+// Observer Interface
+class Observer {
+public:
+    virtual void update(float temperature) = 0;  // Update method to be called when subject's state changes
+    // Batch overload: receives several values in one call (defaults to one update(float) per value)
+    virtual void update(std::span<const float> temperatures) {
+        for (float temperature : temperatures) {
+            update(temperature);
+        }
+    }
+    virtual ~Observer() = default;
+};
+
+// Subject Interface (Observable)
+class Subject {
+public:
+    virtual void addObserver(std::shared_ptr<Observer> observer) = 0;
+    virtual void removeObserver(std::shared_ptr<Observer> observer) = 0;
+    virtual void notifyObservers() = 0;
+    virtual ~Subject() = default;
+};
+
+// ConcreteSubject (WeatherStation)
+class WeatherStation : public Subject {
+private:
+    float temperature = 0.0f;  // Current temperature (the state)
+    std::vector<std::shared_ptr<Observer>> observers;  // List of observers
+
+public:
+    // Add an observer to the list
+    void addObserver(std::shared_ptr<Observer> observer) override {
+        observers.push_back(observer);
+    }
+
+    // Remove an observer from the list
+    void removeObserver(std::shared_ptr<Observer> observer) override {
+        observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+    }
+
+    // Notify all observers of the state change
+    void notifyObservers() override {
+        for (const auto& observer : observers) {
+            observer->update(temperature);
+        }
+    }
+
+    // Change the temperature and notify the observers
+    void setTemperature(float newTemperature) {
+        logEvent<LogLevel::Info>("WeatherStation: New temperature is ", newTemperature, " degrees.");
+        temperature = newTemperature;
+        notifyObservers();  // Notify all observers of the change
+    }
+};
+
+// ConcreteObserver (PhoneDisplay)
+class PhoneDisplay : public Observer {
+public:
+    using Observer::update;
+
+    void update(float temperature) override {
+        static CallSite site("PhoneDisplay::update");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("PhoneDisplay: The temperature is now ", temperature, " degrees.");
+    }
+};
+
+// ConcreteObserver (WindowDisplay)
+class WindowDisplay : public Observer {
+public:
+    using Observer::update;
+
+    void update(float temperature) override {
+        static CallSite site("WindowDisplay::update");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("WindowDisplay: The temperature is now ", temperature, " degrees.");
+    }
+};
+
+// Thread-safe subject: lock-free notification over copy-on-write snapshots, O(1) unsubscribe by token
+class ConcurrentWeatherStation : public Subject {
+private:
+    struct Entry {
+        std::shared_ptr<Observer> observer;
+        std::atomic<bool> active{true};
+
+        explicit Entry(std::shared_ptr<Observer> subscriber) : observer(std::move(subscriber)) {}
+    };
+
+    using Snapshot = std::vector<std::shared_ptr<Entry>>;
+
+    std::atomic<float> temperature{0.0f};
+    std::atomic<std::shared_ptr<const Snapshot>> observers{std::make_shared<const Snapshot>()};
+    std::atomic<std::size_t> liveCount{0};
+    std::atomic<std::size_t> deadCount{0};
+    std::mutex writerMutex;  // Serializes subscribe/unsubscribe compaction, never taken by notifyObservers()
+
+    // Publishes a new snapshot without the inactive entries (writerMutex must be held)
+    void compact() {
+        auto current = observers.load(std::memory_order_acquire);
+        auto next = std::make_shared<Snapshot>();
+        next->reserve(liveCount.load(std::memory_order_relaxed));
+        for (const auto& entry : *current) {
+            if (entry->active.load(std::memory_order_acquire)) {
+                next->push_back(entry);
+            }
+        }
+        forgetDead(current->size() - next->size());
+        observers.store(std::move(next), std::memory_order_release);
+    }
+
+    // Takes the entries a new snapshot dropped off deadCount. Not a reset to zero: an unsubscribe racing with the
+    // copy may already have counted an entry that is still in it. One that cleared `active` but has not counted
+    // yet can briefly wrap deadCount, which at worst triggers an early compaction.
+    void forgetDead(std::size_t dropped) {
+        deadCount.fetch_sub(dropped, std::memory_order_relaxed);
+    }
+
+public:
+    // Token returned by subscribe(); pass it to unsubscribe() to remove the observer in O(1)
+    class Subscription {
+    private:
+        std::shared_ptr<Entry> entry;
+        friend class ConcurrentWeatherStation;
+
+    public:
+        Subscription() = default;
+        explicit Subscription(std::shared_ptr<Entry> subscribed) : entry(std::move(subscribed)) {}
+
+        bool active() const { return entry && entry->active.load(std::memory_order_acquire); }
+    };
+
+    Subscription subscribe(std::shared_ptr<Observer> observer) {
+        auto entry = std::make_shared<Entry>(std::move(observer));
+        std::lock_guard<std::mutex> lock(writerMutex);
+        auto current = observers.load(std::memory_order_acquire);
+        auto next = std::make_shared<Snapshot>();
+        next->reserve(current->size() + 1);
+        for (const auto& existing : *current) {
+            if (existing->active.load(std::memory_order_acquire)) {
+                next->push_back(existing);
+            }
+        }
+        forgetDead(current->size() - next->size());
+        next->push_back(entry);
+        liveCount.fetch_add(1, std::memory_order_relaxed);
+        observers.store(std::move(next), std::memory_order_release);
+        return Subscription(std::move(entry));
+    }
+
+    void unsubscribe(const Subscription& subscription) {
+        if (!subscription.entry || !subscription.entry->active.exchange(false, std::memory_order_acq_rel)) {
+            return;  // Never subscribed or already unsubscribed
+        }
+        liveCount.fetch_sub(1, std::memory_order_relaxed);
+        std::size_t dead = deadCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (dead > liveCount.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            if (deadCount.load(std::memory_order_relaxed) > liveCount.load(std::memory_order_relaxed)) {
+                compact();
+            }
+        }
+    }
+
+    // Subject interface, kept for compatibility with WeatherStation callers
+    void addObserver(std::shared_ptr<Observer> observer) override {
+        subscribe(std::move(observer));
+    }
+
+    // O(n): finds the observer's entry first; prefer unsubscribe(token)
+    void removeObserver(std::shared_ptr<Observer> observer) override {
+        auto current = observers.load(std::memory_order_acquire);
+        for (const auto& entry : *current) {
+            if (entry->observer == observer) {
+                unsubscribe(Subscription(entry));
+            }
+        }
+    }
+
+    // Lock-free: walks the current snapshot and skips unsubscribed entries
+    void notifyObservers() override {
+        auto snapshot = observers.load(std::memory_order_acquire);
+        float current = temperature.load(std::memory_order_relaxed);
+        for (const auto& entry : *snapshot) {
+            if (entry->active.load(std::memory_order_acquire)) {
+                entry->observer->update(current);
+            }
+        }
+    }
+
+    void setTemperature(float newTemperature) {
+        temperature.store(newTemperature, std::memory_order_relaxed);
+        notifyObservers();
+    }
+
+    std::size_t observerCount() const {
+        return liveCount.load(std::memory_order_relaxed);
+    }
+};
+
+enum class ConflationPolicy {
+    DeliverAll,       // Every value is delivered; values that do not fit in the ring are dropped and counted
+    LatestValueWins,  // Only the newest value is delivered; older undelivered values are conflated
+};
+
+// Bounded single-producer/single-consumer ring buffer; capacity is rounded up to a power of two
+template <typename T>
+class SpscRing {
+private:
+    std::vector<T> slots;
+    std::size_t mask;
+    alignas(kCacheLineSize) std::atomic<std::size_t> head{0};  // Next slot to read, written by the consumer
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail{0};  // Next slot to write, written by the producer
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t value) {
+        std::size_t power = 1;
+        while (power < value) {
+            power <<= 1;
+        }
+        return power;
+    }
+
+public:
+    explicit SpscRing(std::size_t capacity)
+        : slots(roundUpToPowerOfTwo(std::max<std::size_t>(capacity, 1))), mask(slots.size() - 1) {}
+
+    // Producer side: returns false instead of blocking when the ring is full
+    bool tryPush(const T& value) {
+        std::size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail - head.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+        slots[currentTail & mask] = value;
+        tail.store(currentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: returns false when the ring is empty
+    bool tryPop(T& value) {
+        std::size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots[currentHead & mask];
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+};
+
+// Snapshot of an AsyncObserver's queue
+struct ObserverQueueStats {
+    std::size_t depth;        // Values waiting to be delivered
+    std::uint64_t delivered;  // Values handed to the wrapped observer
+    std::uint64_t dropped;    // Values lost to a full ring (DeliverAll) or conflated away (LatestValueWins)
+};
+
+// Observer decorator that moves the wrapped observer's update() onto its own worker thread
+class AsyncObserver : public Observer {
+private:
+    std::shared_ptr<Observer> target;
+    ConflationPolicy policy;
+    SpscRing<float> ring;
+    // LatestValueWins slot: the float's bits plus kPending while undelivered, swapped in and out as one word so
+    // that every stored value is delivered at most once
+    static constexpr std::uint64_t kPending = std::uint64_t{1} << 32;
+    std::atomic<std::uint64_t> latest{0};
+    std::atomic<std::uint64_t> delivered{0};
+    std::atomic<std::uint64_t> dropped{0};
+    std::atomic<std::uint32_t> signal{0};  // Bumped by the producer to wake the worker
+    std::atomic<bool> running{true};
+    std::thread worker;
+
+    // Delivers everything currently queued; returns false if there was nothing to deliver
+    bool drainOnce() {
+        bool any = false;
+        if (policy == ConflationPolicy::LatestValueWins) {
+            std::uint64_t slot = latest.exchange(0, std::memory_order_acq_rel);
+            if (slot & kPending) {
+                deliver(std::bit_cast<float>(static_cast<std::uint32_t>(slot)));
+                any = true;
+            }
+        } else {
+            float value;
+            while (ring.tryPop(value)) {
+                deliver(value);
+                any = true;
+            }
+        }
+        return any;
+    }
+
+    void deliver(float value) {
+        target->update(value);
+        delivered.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void run() {
+        while (running.load(std::memory_order_acquire)) {
+            std::uint32_t seen = signal.load(std::memory_order_acquire);
+            if (!drainOnce()) {
+                signal.wait(seen, std::memory_order_acquire);
+            }
+        }
+        drainOnce();  // Deliver whatever was queued before shutdown
+    }
+
+    void wake() {
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+    }
+
+public:
+    using Observer::update;
+
+    AsyncObserver(std::shared_ptr<Observer> wrapped, ConflationPolicy conflation, std::size_t capacity = 1024)
+        : target(std::move(wrapped)), policy(conflation), ring(capacity) {
+        worker = std::thread([this] { run(); });
+    }
+
+    AsyncObserver(const AsyncObserver&) = delete;
+    AsyncObserver& operator=(const AsyncObserver&) = delete;
+
+    ~AsyncObserver() override {
+        running.store(false, std::memory_order_release);
+        wake();
+        worker.join();
+    }
+
+    // Producer side: never blocks
+    void update(float temperature) override {
+        if (policy == ConflationPolicy::LatestValueWins) {
+            std::uint64_t slot = kPending | std::bit_cast<std::uint32_t>(temperature);
+            if (latest.exchange(slot, std::memory_order_acq_rel) & kPending) {
+                dropped.fetch_add(1, std::memory_order_relaxed);  // The previous value was never delivered
+                return;
+            }
+        } else if (!ring.tryPush(temperature)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        wake();
+    }
+
+    ObserverQueueStats stats() const {
+        std::size_t depth = policy == ConflationPolicy::LatestValueWins
+                                ? static_cast<std::size_t>((latest.load(std::memory_order_relaxed) & kPending) != 0)
+                                : ring.size();
+        return ObserverQueueStats{depth, delivered.load(std::memory_order_relaxed),
+                                  dropped.load(std::memory_order_relaxed)};
+    }
+};
+
+using StationId = std::uint32_t;
+inline constexpr StationId kAnyStation = std::numeric_limits<StationId>::max();
+
+// Closed temperature interval a subscriber is interested in (the default covers everything)
+struct TemperatureRange {
+    float min = -std::numeric_limits<float>::infinity();
+    float max = std::numeric_limits<float>::infinity();
+
+    bool operator==(const TemperatureRange& other) const { return min == other.min && max == other.max; }
+};
+
+// Subject for many stations: filters batches by topic and range before dispatching them
+class WeatherHub {
+private:
+    struct RangeGroup {
+        TemperatureRange range;
+        std::vector<std::shared_ptr<Observer>> observers;
+    };
+
+    struct PredicateSubscription {
+        std::function<bool(float)> predicate;
+        std::shared_ptr<Observer> observer;
+    };
+
+    struct Topic {
+        std::vector<RangeGroup> groups;
+        std::vector<PredicateSubscription> predicates;
+    };
+
+    std::unordered_map<StationId, Topic> topics;  // kAnyStation holds the wildcard subscriptions
+    std::vector<float> scratch;
+    std::uint64_t batchesDelivered = 0;
+
+    // Branchless compaction of the readings inside range into scratch
+    std::span<const float> filter(std::span<const float> readings, const TemperatureRange& range) {
+        scratch.resize(readings.size());
+        float* out = scratch.data();
+        std::size_t matched = 0;
+        for (float reading : readings) {
+            out[matched] = reading;
+            matched += static_cast<std::size_t>((reading >= range.min) & (reading <= range.max));
+        }
+        return std::span<const float>(scratch.data(), matched);
+    }
+
+    void dispatch(Topic& topic, std::span<const float> readings, float lowest, float highest) {
+        for (RangeGroup& group : topic.groups) {
+            if (group.range.max < lowest || group.range.min > highest) {
+                continue;  // Nothing in this batch can match
+            }
+            std::span<const float> matched = (group.range.min <= lowest && highest <= group.range.max)
+                                                 ? readings  // Everything matches, no copy needed
+                                                 : filter(readings, group.range);
+            if (matched.empty()) {
+                continue;
+            }
+            for (const auto& observer : group.observers) {
+                observer->update(matched);
+            }
+            batchesDelivered += group.observers.size();
+        }
+
+        for (PredicateSubscription& subscription : topic.predicates) {
+            scratch.clear();
+            for (float reading : readings) {
+                if (subscription.predicate(reading)) {
+                    scratch.push_back(reading);
+                }
+            }
+            if (!scratch.empty()) {
+                subscription.observer->update(std::span<const float>(scratch));
+                ++batchesDelivered;
+            }
+        }
+    }
+
+public:
+    // Subscribes to one station (or kAnyStation) for readings inside range
+    void subscribe(std::shared_ptr<Observer> observer, StationId station = kAnyStation, TemperatureRange range = {}) {
+        Topic& topic = topics[station];
+        auto group = std::find_if(topic.groups.begin(), topic.groups.end(),
+                                  [&](const RangeGroup& existing) { return existing.range == range; });
+        if (group == topic.groups.end()) {
+            topic.groups.push_back(RangeGroup{range, {}});
+            group = topic.groups.end() - 1;
+        }
+        group->observers.push_back(std::move(observer));
+    }
+
+    // Subscribes to one station (or kAnyStation) for readings accepted by an arbitrary predicate
+    void subscribeIf(std::shared_ptr<Observer> observer, StationId station, std::function<bool(float)> predicate) {
+        topics[station].predicates.push_back(PredicateSubscription{std::move(predicate), std::move(observer)});
+    }
+
+    // Removes every subscription of observer
+    void unsubscribe(const std::shared_ptr<Observer>& observer) {
+        for (auto& [station, topic] : topics) {
+            for (RangeGroup& group : topic.groups) {
+                group.observers.erase(std::remove(group.observers.begin(), group.observers.end(), observer),
+                                      group.observers.end());
+            }
+            topic.predicates.erase(std::remove_if(topic.predicates.begin(), topic.predicates.end(),
+                                                  [&](const PredicateSubscription& subscription) {
+                                                      return subscription.observer == observer;
+                                                  }),
+                                   topic.predicates.end());
+        }
+    }
+
+    // Publishes a batch of readings from one station to the matching subscribers
+    void publish(StationId station, std::span<const float> readings) {
+        if (readings.empty()) {
+            return;
+        }
+        auto [lowest, highest] = std::minmax_element(readings.begin(), readings.end());
+        if (auto found = topics.find(station); found != topics.end()) {
+            dispatch(found->second, readings, *lowest, *highest);
+        }
+        if (station != kAnyStation) {
+            if (auto wildcard = topics.find(kAnyStation); wildcard != topics.end()) {
+                dispatch(wildcard->second, readings, *lowest, *highest);
+            }
+        }
+    }
+
+    void publish(StationId station, float reading) {
+        publish(station, std::span<const float>(&reading, 1));
+    }
+
+    // Number of update() calls made so far, one per subscriber per batch at most
+    std::uint64_t deliveredBatches() const { return batchesDelivered; }
+};
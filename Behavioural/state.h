@@ -0,0 +1,658 @@
+// State pattern classes. state.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class BufferPool;
+
+// Reference-counted handle to a fixed-size buffer owned by a BufferPool
+class PacketBuffer {
+private:
+    struct Block {
+        std::atomic<std::uint32_t> references{0};
+        std::size_t used = 0;
+        BufferPool* pool = nullptr;
+        std::unique_ptr<std::byte[]> bytes;
+    };
+
+    Block* block = nullptr;
+
+    explicit PacketBuffer(Block* acquired) : block(acquired) {
+        block->references.store(1, std::memory_order_relaxed);
+    }
+
+    void release();
+
+    friend class BufferPool;
+
+public:
+    PacketBuffer() = default;
+
+    PacketBuffer(const PacketBuffer& other) : block(other.block) {
+        if (block != nullptr) {
+            block->references.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    PacketBuffer(PacketBuffer&& other) noexcept : block(std::exchange(other.block, nullptr)) {}
+
+    PacketBuffer& operator=(PacketBuffer other) noexcept {
+        std::swap(block, other.block);
+        return *this;
+    }
+
+    ~PacketBuffer() { release(); }
+
+    // Whole buffer, for filling it before it is shared; empty for a default-constructed handle
+    std::span<std::byte> writable();
+
+    // Marks how many bytes of the buffer hold data (clamped to the capacity, which is 0 without a buffer)
+    void resize(std::size_t bytes) {
+        if (block != nullptr) {
+            block->used = std::min(bytes, capacity());
+        }
+    }
+
+    std::span<const std::byte> bytes() const {
+        return block == nullptr ? std::span<const std::byte>() : std::span<const std::byte>(block->bytes.get(), block->used);
+    }
+
+    std::size_t size() const { return block == nullptr ? 0 : block->used; }
+    std::size_t capacity() const;
+};
+
+// Pool of fixed-size buffers; released buffers go to a free list and are handed out again
+class BufferPool {
+private:
+    using Block = PacketBuffer::Block;
+
+    std::size_t blockSize;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Block>> blocks;
+    std::vector<Block*> freeBlocks;
+
+    void recycle(Block* block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        block->used = 0;
+        freeBlocks.push_back(block);
+    }
+
+    friend class PacketBuffer;
+
+public:
+    explicit BufferPool(std::size_t bytesPerBuffer = 16 * 1024) : blockSize(bytesPerBuffer) {}
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    PacketBuffer acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        Block* block;
+        if (freeBlocks.empty()) {
+            blocks.push_back(std::make_unique<Block>());
+            block = blocks.back().get();
+            block->pool = this;
+            block->bytes = std::make_unique<std::byte[]>(blockSize);
+        } else {
+            block = freeBlocks.back();
+            freeBlocks.pop_back();
+        }
+        return PacketBuffer(block);
+    }
+
+    std::size_t bufferSize() const { return blockSize; }
+    std::size_t allocatedBuffers() const { return blocks.size(); }
+};
+
+inline void PacketBuffer::release() {
+    if (block != nullptr && block->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        block->pool->recycle(block);
+    }
+    block = nullptr;
+}
+
+inline std::span<std::byte> PacketBuffer::writable() {
+    if (block == nullptr) {
+        return {};
+    }
+    return std::span<std::byte>(block->bytes.get(), block->pool->bufferSize());
+}
+
+inline std::size_t PacketBuffer::capacity() const {
+    return block == nullptr ? 0 : block->pool->bufferSize();
+}
+
+// Part of a PacketBuffer; keeps the buffer alive
+struct PacketSlice {
+    PacketBuffer buffer;
+    std::size_t offset;
+    std::size_t length;
+
+    std::span<const std::byte> bytes() const { return buffer.bytes().subspan(offset, length); }
+};
+
+// Scatter/gather list of buffer slices making up one payload
+class PacketChain {
+private:
+    std::vector<PacketSlice> slices;
+    std::size_t totalBytes = 0;
+
+public:
+    // Appends buffer[offset, offset + length); throws std::out_of_range if that is not inside the buffer's data
+    void append(PacketBuffer buffer, std::size_t offset, std::size_t length) {
+        if (offset > buffer.size() || length > buffer.size() - offset) {
+            throw std::out_of_range("packet slice outside its buffer");
+        }
+        totalBytes += length;
+        slices.push_back(PacketSlice{std::move(buffer), offset, length});
+    }
+
+    void append(PacketBuffer buffer) {
+        std::size_t length = buffer.size();
+        append(std::move(buffer), 0, length);
+    }
+
+    // The one copy at ingress: fills as many pooled buffers as source needs
+    static PacketChain copyFrom(BufferPool& pool, std::span<const std::byte> source) {
+        PacketChain chain;
+        while (!source.empty()) {
+            PacketBuffer buffer = pool.acquire();
+            std::size_t chunk = std::min(source.size(), buffer.capacity());
+            std::memcpy(buffer.writable().data(), source.data(), chunk);
+            buffer.resize(chunk);
+            chain.append(std::move(buffer));
+            source = source.subspan(chunk);
+        }
+        return chain;
+    }
+
+    const std::vector<PacketSlice>& segments() const { return slices; }
+    std::size_t size() const { return totalBytes; }
+};
+
+inline std::string_view asText(std::span<const std::byte> bytes) {
+    return std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+// The packet's slices copied into one contiguous string
+inline std::string gatherText(const PacketChain& packet) {
+    std::string text;
+    text.reserve(packet.size());
+    for (const PacketSlice& slice : packet.segments()) {
+        text += asText(slice.bytes());
+    }
+    return text;
+}
+
+// State Interface
+class State {
+public:
+    virtual void open() = 0;      // Method to transition to the "Open" state
+    virtual void close() = 0;     // Method to transition to the "Closed" state
+    virtual void sendData(const std::string& data) = 0;  // Method to handle data sending
+    virtual void receiveData(const std::string& data) = 0;  // Method to handle data reception
+
+    // Views of the payload. By default they copy it for the std::string overloads; states override them to avoid that.
+    virtual void sendData(std::string_view data) { sendData(std::string(data)); }
+    virtual void receiveData(std::string_view data) { receiveData(std::string(data)); }
+
+    // String literals would otherwise be ambiguous between the two overloads above
+    void sendData(const char* data) { sendData(std::string_view(data)); }
+    void receiveData(const char* data) { receiveData(std::string_view(data)); }
+
+    // Binary payloads, viewed without a copy
+    virtual void sendData(std::span<const std::byte> data) { sendData(asText(data)); }
+    virtual void receiveData(std::span<const std::byte> data) { receiveData(asText(data)); }
+
+    // Scatter/gather payloads, handled as one payload: a multi-slice packet is gathered into one copy by default
+    virtual void sendData(const PacketChain& packet) {
+        if (packet.segments().size() == 1) {
+            sendData(packet.segments().front().bytes());
+        } else {
+            sendData(gatherText(packet));
+        }
+    }
+    virtual void receiveData(const PacketChain& packet) {
+        if (packet.segments().size() == 1) {
+            receiveData(packet.segments().front().bytes());
+        } else {
+            receiveData(gatherText(packet));
+        }
+    }
+
+    virtual ~State() = default;
+};
+
+// Context (TCPConnection)
+class TCPConnection {
+private:
+    std::shared_ptr<State> state;  // Current state of the TCP connection
+
+public:
+    TCPConnection(std::shared_ptr<State> initialState) : state(initialState) {}
+
+    void setState(std::shared_ptr<State> newState) {
+        state = newState;
+    }
+
+    void open() {
+        state->open();
+    }
+
+    void close() {
+        state->close();
+    }
+
+    void sendData(std::string_view data) {
+        state->sendData(data);
+    }
+
+    void receiveData(std::string_view data) {
+        state->receiveData(data);
+    }
+
+    void sendData(std::span<const std::byte> data) {
+        state->sendData(data);
+    }
+
+    void receiveData(std::span<const std::byte> data) {
+        state->receiveData(data);
+    }
+
+    // Passed by reference all the way to the state: the payload is never copied
+    void sendData(const PacketChain& packet) {
+        state->sendData(packet);
+    }
+
+    void receiveData(const PacketChain& packet) {
+        state->receiveData(packet);
+    }
+};
+
+// ConcreteState: Closed
+class ClosedState : public State {
+public:
+    using State::sendData;
+    using State::receiveData;
+
+    void open() override {
+        logEvent<LogLevel::Info>("Transitioning from Closed to Listening state.");
+        // Transition to Listening state
+    }
+
+    void close() override {
+        logEvent<LogLevel::Info>("Already in Closed state.");
+    }
+
+    void sendData(const std::string& data) override { sendData(std::string_view(data)); }
+    void receiveData(const std::string& data) override { receiveData(std::string_view(data)); }
+
+    void sendData(std::string_view) override {
+        static CallSite site("ClosedState::sendData");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Cannot send data. Connection is closed.");
+    }
+
+    void receiveData(std::string_view) override {
+        static CallSite site("ClosedState::receiveData");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Cannot receive data. Connection is closed.");
+    }
+};
+
+// ConcreteState: Listening
+class ListeningState : public State {
+public:
+    using State::sendData;
+    using State::receiveData;
+
+    void open() override {
+        logEvent<LogLevel::Info>("Already in Listening state.");
+    }
+
+    void close() override {
+        logEvent<LogLevel::Info>("Transitioning from Listening to Closed state.");
+        // Transition to Closed state
+    }
+
+    void sendData(const std::string& data) override { sendData(std::string_view(data)); }
+    void receiveData(const std::string& data) override { receiveData(std::string_view(data)); }
+
+    void sendData(std::string_view) override {
+        static CallSite site("ListeningState::sendData");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Cannot send data. Connection is in Listening state.");
+    }
+
+    void receiveData(std::string_view) override {
+        static CallSite site("ListeningState::receiveData");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Transitioning from Listening to Established state.");
+        // Transition to Established state
+    }
+};
+
+// ConcreteState: Established
+class EstablishedState : public State {
+public:
+    void open() override {
+        logEvent<LogLevel::Info>("Already in Established state.");
+    }
+
+    void close() override {
+        logEvent<LogLevel::Info>("Transitioning from Established to Closed state.");
+        // Transition to Closed state
+    }
+
+    void sendData(const std::string& data) override { sendData(std::string_view(data)); }
+    void receiveData(const std::string& data) override { receiveData(std::string_view(data)); }
+
+    void sendData(std::string_view data) override {
+        static CallSite site("EstablishedState::sendData");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Sending data: ", data);
+    }
+
+    void receiveData(std::string_view data) override {
+        static CallSite site("EstablishedState::receiveData");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Receiving data: ", data);
+    }
+
+    using State::sendData;
+    using State::receiveData;
+
+    // Writes the slices straight from the pooled buffers
+    void sendData(const PacketChain& packet) override {
+        static CallSite site("EstablishedState::sendData");
+        ScopedCall call(site);
+        std::ostream& out = eventStream();  // One event per line, however many slices it is written from
+        out << "Sending data (" << packet.size() << " bytes in " << packet.segments().size() << " segments): ";
+        for (const PacketSlice& slice : packet.segments()) {
+            out << asText(slice.bytes());
+        }
+        out << '\n';
+    }
+
+    void receiveData(const PacketChain& packet) override {
+        static CallSite site("EstablishedState::receiveData");
+        ScopedCall call(site);
+        std::ostream& out = eventStream();  // One event per line, however many slices it is written from
+        out << "Receiving data (" << packet.size() << " bytes in " << packet.segments().size() << " segments): ";
+        for (const PacketSlice& slice : packet.segments()) {
+            out << asText(slice.bytes());
+        }
+        out << '\n';
+    }
+};
+
+enum class ConnectionState : std::uint8_t { Closed, Listening, Established, Count };
+enum class ConnectionEvent : std::uint8_t { Open, Close, SendData, ReceiveData, Count };
+
+// What a transition does besides changing the state
+enum class ConnectionAction : std::uint8_t {
+    None,        // Event rejected or ignored in this state
+    Transition,  // State changed
+    Send,        // Payload sent
+    Receive,     // Payload received
+};
+
+struct Transition {
+    ConnectionState next;
+    ConnectionAction action;
+    std::string_view message;
+};
+
+inline constexpr std::size_t kStateCount = static_cast<std::size_t>(ConnectionState::Count);
+inline constexpr std::size_t kEventCount = static_cast<std::size_t>(ConnectionEvent::Count);
+
+// The whole TCP connection state machine, indexed by [current state][event]
+inline constexpr std::array<std::array<Transition, kEventCount>, kStateCount> kTransitions = {{
+    // Closed
+    {{
+        {ConnectionState::Listening, ConnectionAction::Transition, "Transitioning from Closed to Listening state."},
+        {ConnectionState::Closed, ConnectionAction::None, "Already in Closed state."},
+        {ConnectionState::Closed, ConnectionAction::None, "Cannot send data. Connection is closed."},
+        {ConnectionState::Closed, ConnectionAction::None, "Cannot receive data. Connection is closed."},
+    }},
+    // Listening
+    {{
+        {ConnectionState::Listening, ConnectionAction::None, "Already in Listening state."},
+        {ConnectionState::Closed, ConnectionAction::Transition, "Transitioning from Listening to Closed state."},
+        {ConnectionState::Listening, ConnectionAction::None, "Cannot send data. Connection is in Listening state."},
+        {ConnectionState::Established, ConnectionAction::Transition, "Transitioning from Listening to Established state."},
+    }},
+    // Established
+    {{
+        {ConnectionState::Established, ConnectionAction::None, "Already in Established state."},
+        {ConnectionState::Closed, ConnectionAction::Transition, "Transitioning from Established to Closed state."},
+        {ConnectionState::Established, ConnectionAction::Send, "Sending data: "},
+        {ConnectionState::Established, ConnectionAction::Receive, "Receiving data: "},
+    }},
+}};
+
+constexpr const Transition& lookupTransition(ConnectionState state, ConnectionEvent event) {
+    return kTransitions[static_cast<std::size_t>(state)][static_cast<std::size_t>(event)];
+}
+
+// The table must describe the same machine as the State classes, with the transitions they only print about
+static_assert(lookupTransition(ConnectionState::Closed, ConnectionEvent::Open).next == ConnectionState::Listening);
+static_assert(lookupTransition(ConnectionState::Listening, ConnectionEvent::ReceiveData).next == ConnectionState::Established);
+static_assert(lookupTransition(ConnectionState::Established, ConnectionEvent::Close).next == ConnectionState::Closed);
+
+// Context driven by the transition table; the whole connection is one byte
+class TableTCPConnection {
+private:
+    ConnectionState state = ConnectionState::Closed;
+
+    void handle(ConnectionEvent event, std::string_view data = {}) {
+        static CallSite site("TableTCPConnection::handle");
+        ScopedCall call(site);
+        const Transition& transition = step(event);
+        bool carriesData =
+            transition.action == ConnectionAction::Send || transition.action == ConnectionAction::Receive;
+        logEvent<LogLevel::Info>(transition.message, carriesData ? data : std::string_view());
+    }
+
+public:
+    TableTCPConnection() = default;
+    explicit TableTCPConnection(ConnectionState initialState) : state(initialState) {}
+
+    // Performs the transition for event with one table lookup and returns the entry that was applied
+    const Transition& step(ConnectionEvent event) {
+        const Transition& transition = lookupTransition(state, event);
+        state = transition.next;
+        return transition;
+    }
+
+    ConnectionState currentState() const { return state; }
+
+    void open() { handle(ConnectionEvent::Open); }
+    void close() { handle(ConnectionEvent::Close); }
+    void sendData(std::string_view data) { handle(ConnectionEvent::SendData, data); }
+    void receiveData(std::string_view data) { handle(ConnectionEvent::ReceiveData, data); }
+};
+
+static_assert(sizeof(TableTCPConnection) == 1, "A table-driven connection should be a single byte");
+
+using ConnectionId = std::uint32_t;
+
+// One event addressed to one connection of a ConnectionTable
+struct ConnectionEventRecord {
+    ConnectionId connection;
+    ConnectionEvent event;
+    std::uint32_t payloadBytes;  // Size of the data for SendData/ReceiveData
+};
+
+// Struct-of-arrays storage for many connections, driven by the transition table in batches
+class ConnectionTable {
+private:
+    std::vector<ConnectionState> states;
+    std::vector<std::uint64_t> bytesSent;
+    std::vector<std::uint64_t> bytesReceived;
+    std::vector<std::uint32_t> unreadBytes;     // Received bytes not yet consumed by the application
+    std::vector<std::uint32_t> rejectedEvents;  // Events the current state did not accept
+    std::vector<std::uint64_t> batchStamps;     // Per connection: last batch that sent it an event (high half) and
+                                                // how many events it got in that batch (low half), one load for both
+
+    std::array<std::vector<std::uint32_t>, kStateCount> buckets;  // Indices into the batch, never copies of events
+    std::vector<std::uint32_t> ranks;       // Per event: how many earlier events of the batch share its connection
+    std::vector<std::size_t> waveStarts;    // Offset of each wave in `waveOrder`, plus the end offset
+    std::vector<std::uint32_t> waveOrder;   // Batch indices ordered by rank, stable within a rank
+    std::uint32_t currentBatch = 0;
+
+    // Tight loop over every event whose connection is in `state`
+    void runBucket(ConnectionState state, std::span<const ConnectionEventRecord> events,
+                   const std::vector<std::uint32_t>& bucket) {
+        const auto& row = kTransitions[static_cast<std::size_t>(state)];
+        for (std::uint32_t index : bucket) {
+            const ConnectionEventRecord& record = events[index];
+            const Transition& transition = row[static_cast<std::size_t>(record.event)];
+            ConnectionId id = record.connection;
+            states[id] = transition.next;
+            switch (transition.action) {
+            case ConnectionAction::Send:
+                bytesSent[id] += record.payloadBytes;
+                break;
+            case ConnectionAction::Receive:
+                bytesReceived[id] += record.payloadBytes;
+                unreadBytes[id] += record.payloadBytes;
+                break;
+            case ConnectionAction::None:
+                ++rejectedEvents[id];
+                break;
+            case ConnectionAction::Transition:
+                break;
+            }
+        }
+    }
+
+    void startBatch() {
+        if (++currentBatch == 0) {  // Stamp counter wrapped: forget all old stamps
+            std::fill(batchStamps.begin(), batchStamps.end(), 0);
+            currentBatch = 1;
+        }
+    }
+
+    // Ranks every event and validates its connection id before anything is applied; returns the highest rank
+    std::uint32_t rankEvents(std::span<const ConnectionEventRecord> events) {
+        startBatch();
+        ranks.resize(events.size());
+        const std::uint64_t stamp = std::uint64_t{currentBatch} << 32;
+        std::uint32_t maxRank = 0;
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            ConnectionId id = events[i].connection;
+            if (id >= states.size()) {
+                throw std::out_of_range("unknown connection " + std::to_string(id));
+            }
+            std::uint64_t& entry = batchStamps[id];
+            entry = (entry & ~0xffffffffull) == stamp ? entry + 1 : stamp;
+            ranks[i] = static_cast<std::uint32_t>(entry);
+            maxRank = std::max(maxRank, ranks[i]);
+        }
+        return maxRank;
+    }
+
+    // Stable counting sort of batch indices by rank: wave r holds every connection's r-th event, in batch order
+    void sortIntoWaves(std::uint32_t maxRank) {
+        waveStarts.assign(std::size_t{maxRank} + 3, 0);
+        for (std::uint32_t rank : ranks) {
+            ++waveStarts[rank + 2];  // Counted two slots up, so placing below leaves waveStarts[r] = start of r
+        }
+        for (std::size_t wave = 2; wave < waveStarts.size(); ++wave) {
+            waveStarts[wave] += waveStarts[wave - 1];
+        }
+        waveOrder.resize(ranks.size());
+        for (std::size_t i = 0; i < ranks.size(); ++i) {
+            waveOrder[waveStarts[ranks[i] + 1]++] = static_cast<std::uint32_t>(i);
+        }
+        waveStarts.pop_back();
+    }
+
+    // Buckets the given batch indices by the current state of their connections, then runs each bucket
+    template <typename Indices>
+    void runWave(std::span<const ConnectionEventRecord> events, Indices indices) {
+        for (auto& bucket : buckets) {
+            bucket.clear();
+        }
+        for (std::uint32_t index : indices) {
+            buckets[static_cast<std::size_t>(states[events[index].connection])].push_back(index);
+        }
+        for (std::size_t state = 0; state < kStateCount; ++state) {
+            runBucket(static_cast<ConnectionState>(state), events, buckets[state]);
+        }
+    }
+
+public:
+    explicit ConnectionTable(std::size_t expectedConnections = 0) {
+        states.reserve(expectedConnections);
+        bytesSent.reserve(expectedConnections);
+        bytesReceived.reserve(expectedConnections);
+        unreadBytes.reserve(expectedConnections);
+        rejectedEvents.reserve(expectedConnections);
+        batchStamps.reserve(expectedConnections);
+    }
+
+    ConnectionId add(ConnectionState initialState = ConnectionState::Closed) {
+        states.push_back(initialState);
+        bytesSent.push_back(0);
+        bytesReceived.push_back(0);
+        unreadBytes.push_back(0);
+        rejectedEvents.push_back(0);
+        batchStamps.push_back(0);
+        return static_cast<ConnectionId>(states.size() - 1);
+    }
+
+    // Applies a batch of events; events for one connection are applied in the order given. Throws
+    // std::out_of_range, before applying any event, if one names a connection that was never added.
+    void process(std::span<const ConnectionEventRecord> events) {
+        std::uint32_t maxRank = rankEvents(events);
+        if (maxRank == 0) {  // No connection repeats: the whole batch is one wave, no sort needed
+            runWave(events, std::views::iota(std::uint32_t{0}, static_cast<std::uint32_t>(events.size())));
+            return;
+        }
+        sortIntoWaves(maxRank);
+        for (std::size_t wave = 0; wave + 1 < waveStarts.size(); ++wave) {
+            // At most one event per connection, bucketed by the state the previous wave left it in
+            runWave(events, std::span<const std::uint32_t>(waveOrder).subspan(
+                                waveStarts[wave], waveStarts[wave + 1] - waveStarts[wave]));
+        }
+    }
+
+    // The application read `bytes` from the connection's receive buffer
+    void consume(ConnectionId id, std::uint32_t bytes) {
+        unreadBytes[id] -= std::min(bytes, unreadBytes[id]);
+    }
+
+    std::size_t size() const { return states.size(); }
+    ConnectionState state(ConnectionId id) const { return states[id]; }
+    std::uint64_t sent(ConnectionId id) const { return bytesSent[id]; }
+    std::uint64_t received(ConnectionId id) const { return bytesReceived[id]; }
+    std::uint32_t unread(ConnectionId id) const { return unreadBytes[id]; }
+    std::uint32_t rejected(ConnectionId id) const { return rejectedEvents[id]; }
+
+    // Number of connections currently in each state
+    std::array<std::size_t, kStateCount> stateHistogram() const {
+        std::array<std::size_t, kStateCount> histogram{};
+        for (ConnectionState state : states) {
+            ++histogram[static_cast<std::size_t>(state)];
+        }
+        return histogram;
+    }
+};
@@ -50,70 +50,141 @@ The Strategy pattern is useful for scenarios where you need to switch between di
 By encapsulating each algorithm in its own class and providing a common interface, the Strategy pattern promotes flexibility,
 encapsulation, and reusability, allowing the client to select and change strategies at runtime.
 
+Zero-Virtual Dispatch:
+PaymentContext holds a std::shared_ptr<PaymentStrategy>: setStrategy() touches an atomic reference count and every
+processPayment() is a virtual call. When the strategy set is known up front, two contexts avoid both:
+- StaticPaymentContext<Strategy>: Policy-based. The strategy is a member of a known, final type, so pay() is a
+  direct call the compiler can inline.
+- VariantPaymentContext<Strategies...>: For a closed set that still changes at runtime. The strategy lives in a
+  std::variant by value and std::visit dispatches through a jump table with every alternative inlinable.
+  ClosedPaymentContext is the variant context over CreditCardPayment and PayPalPayment.
+
+Batched, Asynchronous Payments:
+pay(float) handles one amount synchronously. For bursty traffic:
+- payBatch(std::span<const float>) processes many amounts in one call. The concrete strategies format the whole
+  batch into one buffer and write it to their output stream once, instead of flushing with std::endl per line.
+  Each batch is recorded once in its own call site ("CreditCardPayment::payBatch"), with the batch size as the
+  site's item count, so batched payments show up in the metrics even though they never go through pay().
+- PaymentPipeline groups requests by strategy: every registered strategy gets its own lane, which is a bounded
+  multi-producer/single-consumer queue drained by a dedicated worker thread. The worker takes up to maxBatch
+  requests at a time, hands them to payBatch() and then completes each request's std::future or callback.
+  A full queue blocks the submitter (backpressure) instead of growing without bound.
+
 */
-#include <iostream>
-#include <memory>
-#include <string>
+#include "strategy.h"
 
-// Strategy Interface
-class PaymentStrategy {
-public:
-    virtual void pay(float amount) const = 0;  // Method to process payment
-    virtual ~PaymentStrategy() = default;
-};
+#include <chrono>
+#include <iostream>
+#include <streambuf>
 
-// ConcreteStrategy 1: CreditCardPayment
-class CreditCardPayment : public PaymentStrategy {
+// Benchmark strategies: record the amount instead of printing, so the measurement is the dispatch itself
+class LedgerPayment final : public PaymentStrategy {
 private:
-    std::string cardNumber;
-    std::string cardHolder;
+    double* ledger;
 
 public:
-    CreditCardPayment(const std::string& number, const std::string& holder)
-        : cardNumber(number), cardHolder(holder) {}
+    explicit LedgerPayment(double& total) : ledger(&total) {}
 
     void pay(float amount) const override {
-        std::cout << "Processing credit card payment of $" << amount
-                  << " for card holder " << cardHolder << " with card number "
-                  << cardNumber << "." << std::endl;
+        *ledger += amount;
     }
 };
 
-// ConcreteStrategy 2: PayPalPayment
-class PayPalPayment : public PaymentStrategy {
+class RefundPayment final : public PaymentStrategy {
 private:
-    std::string email;
+    double* ledger;
 
 public:
-    PayPalPayment(const std::string& emailAddress) : email(emailAddress) {}
+    explicit RefundPayment(double& total) : ledger(&total) {}
 
     void pay(float amount) const override {
-        std::cout << "Processing PayPal payment of $" << amount
-                  << " for email address " << email << "." << std::endl;
+        *ledger -= amount;
     }
 };
 
-// Context: Uses the Strategy to process payments
-class PaymentContext {
+// Stream buffer that formats into a fixed scratch area and discards it, standing in for a fast output device
+class DiscardBuffer : public std::streambuf {
 private:
-    std::shared_ptr<PaymentStrategy> strategy;  // Strategy object
+    char scratch[4096];
 
-public:
-    // Set the payment strategy
-    void setStrategy(std::shared_ptr<PaymentStrategy> newStrategy) {
-        strategy = newStrategy;
+protected:
+    int overflow(int ch) override {
+        setp(scratch, scratch + sizeof(scratch));
+        return traits_type::not_eof(ch);
     }
 
-    // Process payment using the current strategy
-    void processPayment(float amount) const {
-        if (strategy) {
-            strategy->pay(amount);
-        } else {
-            std::cout << "No payment strategy set!" << std::endl;
-        }
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        return count;
+    }
+
+public:
+    DiscardBuffer() {
+        setp(scratch, scratch + sizeof(scratch));
     }
 };
 
+template <typename Context>
+double measurePayments(const Context& context, const std::vector<float>& amounts) {
+    auto begin = std::chrono::steady_clock::now();
+    for (float amount : amounts) {
+        context.processPayment(amount);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / static_cast<double>(amounts.size());
+}
+
+// Compares ns per payment for the shared_ptr/virtual, policy-based and variant dispatch models
+void runDispatchBenchmark() {
+    std::vector<float> amounts(10'000'000);
+    for (std::size_t i = 0; i < amounts.size(); ++i) {
+        amounts[i] = static_cast<float>(i % 100) + 0.5f;
+    }
+    double total = 0.0;
+
+    PaymentContext virtualContext;
+    virtualContext.setStrategy(std::make_shared<LedgerPayment>(total));
+    StaticPaymentContext<LedgerPayment> staticContext{LedgerPayment(total)};
+    VariantPaymentContext<LedgerPayment, RefundPayment> variantContext{LedgerPayment(total)};
+
+    std::cout << "\nProcessing " << amounts.size() << " payments:\n";
+    std::cout << "shared_ptr + virtual:  " << measurePayments(virtualContext, amounts) << " ns/payment\n";
+    std::cout << "StaticPaymentContext:  " << measurePayments(staticContext, amounts) << " ns/payment\n";
+    std::cout << "VariantPaymentContext: " << measurePayments(variantContext, amounts) << " ns/payment\n";
+    std::cout << "(ledger total " << total << ")\n";
+}
+
+// Throughput and p99 latency of the pipeline for different batch sizes
+void runPipelineBenchmark() {
+    const std::size_t payments = 200'000;
+    DiscardBuffer discard;
+    std::ostream sink(&discard);
+
+    std::cout << "\nPaymentPipeline with " << payments << " payments over 2 strategies:\n";
+    std::cout << "batch\tpayments/s\tp99 latency (us)\n";
+    for (std::size_t batchSize : {1, 16, 256}) {
+        std::vector<std::chrono::steady_clock::duration> latencies(payments);
+        auto begin = std::chrono::steady_clock::now();
+        {
+            PaymentPipeline pipeline(1024, batchSize);
+            auto card = pipeline.addStrategy(std::make_shared<CreditCardPayment>("1234-5678-9876-5432", "John Doe", sink));
+            auto payPal = pipeline.addStrategy(std::make_shared<PayPalPayment>("john.doe@example.com", sink));
+            for (std::size_t i = 0; i < payments; ++i) {
+                auto submitted = std::chrono::steady_clock::now();
+                pipeline.submit(i % 2 == 0 ? card : payPal, static_cast<float>(i % 500),
+                                [&latencies, i, submitted](std::exception_ptr) {
+                                    latencies[i] = std::chrono::steady_clock::now() - submitted;
+                                });
+            }
+        }  // Destructor drains the queues
+        auto end = std::chrono::steady_clock::now();
+
+        std::sort(latencies.begin(), latencies.end());
+        double seconds = std::chrono::duration<double>(end - begin).count();
+        double p99 = std::chrono::duration<double, std::micro>(latencies[payments * 99 / 100]).count();
+        std::cout << batchSize << '\t' << static_cast<double>(payments) / seconds << "\t\t" << p99 << '\n';
+    }
+}
+
 // Client code
 int main() {
     // Create payment strategies
@@ -131,5 +202,31 @@ int main() {
     paymentContext.setStrategy(payPal);
     paymentContext.processPayment(200.0f);
 
+    // Strategy known at compile time: direct call, no shared_ptr
+    StaticPaymentContext<CreditCardPayment> cardContext{CreditCardPayment("1234-5678-9876-5432", "John Doe")};
+    cardContext.processPayment(50.0f);
+
+    // Closed set of strategies switched at runtime: std::visit, no shared_ptr
+    ClosedPaymentContext closedContext{PayPalPayment("john.doe@example.com")};
+    closedContext.processPayment(75.0f);
+    closedContext.setStrategy(CreditCardPayment("1234-5678-9876-5432", "John Doe"));
+    closedContext.processPayment(125.0f);
+
+    // Batch API: one buffered write for the whole batch
+    std::vector<float> burst = {10.0f, 20.0f, 30.0f};
+    payPal->payBatch(burst);
+
+    // Asynchronous pipeline: payments are grouped per strategy and processed on worker threads
+    {
+        PaymentPipeline pipeline;
+        auto cardLane = pipeline.addStrategy(creditCard);
+        std::future<void> done = pipeline.submit(cardLane, 300.0f);
+        done.get();
+    }
+
+    flushEvents();  // The benchmarks print to std::cout directly
+    runDispatchBenchmark();
+    runPipelineBenchmark();
+
     return 0;
 }
@@ -0,0 +1,344 @@
+// Strategy pattern classes. strategy.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Strategy Interface
+class PaymentStrategy {
+public:
+    virtual void pay(float amount) const = 0;  // Method to process payment
+    // Method to process many payments at once (defaults to one pay() per amount)
+    virtual void payBatch(std::span<const float> amounts) const {
+        for (float amount : amounts) {
+            pay(amount);
+        }
+    }
+    virtual ~PaymentStrategy() = default;
+};
+
+// ConcreteStrategy 1: CreditCardPayment
+class CreditCardPayment final : public PaymentStrategy {
+private:
+    std::string cardNumber;
+    std::string cardHolder;
+    std::ostream* out;
+
+    void writeReceipt(std::ostream& os, float amount) const {
+        os << "Processing credit card payment of $" << amount
+           << " for card holder " << cardHolder << " with card number "
+           << cardNumber << ".\n";
+    }
+
+public:
+    CreditCardPayment(const std::string& number, const std::string& holder, std::ostream& output = eventStream())
+        : cardNumber(number), cardHolder(holder), out(&output) {}
+
+    void pay(float amount) const override {
+        static CallSite site("CreditCardPayment::pay");
+        ScopedCall call(site);
+        writeReceipt(localStream(*out), amount);
+    }
+
+    // Formats the whole batch into one buffer and writes it with a single call; recorded as one call of the
+    // batch's size, the payments never go through pay()
+    void payBatch(std::span<const float> amounts) const override {
+        static CallSite site("CreditCardPayment::payBatch");
+        ScopedCall call(site, amounts.size());
+        std::ostringstream buffer;
+        for (float amount : amounts) {
+            writeReceipt(buffer, amount);
+        }
+        const std::string receipts = buffer.str();
+        localStream(*out).write(receipts.data(), static_cast<std::streamsize>(receipts.size()));
+    }
+};
+
+// ConcreteStrategy 2: PayPalPayment
+class PayPalPayment final : public PaymentStrategy {
+private:
+    std::string email;
+    std::ostream* out;
+
+    void writeReceipt(std::ostream& os, float amount) const {
+        os << "Processing PayPal payment of $" << amount
+           << " for email address " << email << ".\n";
+    }
+
+public:
+    PayPalPayment(const std::string& emailAddress, std::ostream& output = eventStream())
+        : email(emailAddress), out(&output) {}
+
+    void pay(float amount) const override {
+        static CallSite site("PayPalPayment::pay");
+        ScopedCall call(site);
+        writeReceipt(localStream(*out), amount);
+    }
+
+    // Formats the whole batch into one buffer and writes it with a single call; recorded as one call of the
+    // batch's size, the payments never go through pay()
+    void payBatch(std::span<const float> amounts) const override {
+        static CallSite site("PayPalPayment::payBatch");
+        ScopedCall call(site, amounts.size());
+        std::ostringstream buffer;
+        for (float amount : amounts) {
+            writeReceipt(buffer, amount);
+        }
+        const std::string receipts = buffer.str();
+        localStream(*out).write(receipts.data(), static_cast<std::streamsize>(receipts.size()));
+    }
+};
+
+// Context: Uses the Strategy to process payments
+class PaymentContext {
+private:
+    std::shared_ptr<PaymentStrategy> strategy;  // Strategy object
+
+public:
+    // Set the payment strategy
+    void setStrategy(std::shared_ptr<PaymentStrategy> newStrategy) {
+        strategy = newStrategy;
+    }
+
+    // Process payment using the current strategy
+    void processPayment(float amount) const {
+        if (strategy) {
+            strategy->pay(amount);
+        } else {
+            logEvent<LogLevel::Warn>("No payment strategy set!");
+        }
+    }
+};
+
+// Policy-based context: the strategy type is fixed at compile time, so pay() is a direct, inlinable call
+template <typename Strategy>
+class StaticPaymentContext {
+private:
+    Strategy strategy;
+
+public:
+    explicit StaticPaymentContext(Strategy initialStrategy) : strategy(std::move(initialStrategy)) {}
+
+    void setStrategy(Strategy newStrategy) {
+        strategy = std::move(newStrategy);
+    }
+
+    void processPayment(float amount) const {
+        strategy.pay(amount);
+    }
+};
+
+// Closed-set context: the strategy is held by value in a variant and dispatched with std::visit
+template <typename... Strategies>
+class VariantPaymentContext {
+private:
+    std::variant<Strategies...> strategy;
+
+public:
+    template <typename Strategy>
+    explicit VariantPaymentContext(Strategy initialStrategy) : strategy(std::move(initialStrategy)) {}
+
+    template <typename Strategy>
+    void setStrategy(Strategy newStrategy) {
+        strategy = std::move(newStrategy);
+    }
+
+    void processPayment(float amount) const {
+        std::visit([amount](const auto& current) { current.pay(amount); }, strategy);
+    }
+};
+
+using ClosedPaymentContext = VariantPaymentContext<CreditCardPayment, PayPalPayment>;
+
+// Bounded multi-producer/single-consumer queue: push() blocks while full, the consumer drains in batches
+template <typename T>
+class BoundedQueue {
+private:
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<T> items;
+    std::size_t capacity;
+    bool closed = false;
+
+public:
+    explicit BoundedQueue(std::size_t maxItems) : capacity(std::max<std::size_t>(maxItems, 1)) {}
+
+    // Returns false if the queue was closed before the item could be added
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        lock.unlock();
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Moves up to maxItems items into out; waits for at least one. Returns false once closed and drained.
+    bool popBatch(std::vector<T>& out, std::size_t maxItems) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) {
+            return false;
+        }
+        std::size_t count = std::min(maxItems, items.size());
+        for (std::size_t i = 0; i < count; ++i) {
+            out.push_back(std::move(items.front()));
+            items.pop_front();
+        }
+        lock.unlock();
+        notFull.notify_all();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+};
+
+// Groups payments by strategy and processes them in batches on one worker thread per strategy
+class PaymentPipeline {
+public:
+    using StrategyId = std::size_t;
+    // Called on the worker thread once the payment is done (error is null on success). Must not throw: an exception
+    // from it is logged and dropped, so that the rest of the batch is still completed.
+    using Completion = std::function<void(std::exception_ptr error)>;
+
+private:
+    struct Request {
+        float amount;
+        std::promise<void> promise;
+        Completion completion;  // Used instead of the promise when set
+    };
+
+    struct Lane {
+        std::shared_ptr<PaymentStrategy> strategy;
+        BoundedQueue<Request> queue;
+        std::thread worker;
+
+        Lane(std::shared_ptr<PaymentStrategy> laneStrategy, std::size_t capacity)
+            : strategy(std::move(laneStrategy)), queue(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<Lane>> lanes;
+    std::size_t queueCapacity;
+    std::size_t maxBatch;
+
+    static void complete(Request& request, const std::exception_ptr& error) {
+        if (request.completion) {
+            try {
+                request.completion(error);
+            } catch (...) {
+                logEvent<LogLevel::Error>("PaymentPipeline: a completion threw; the exception was dropped");
+            }
+        } else if (error) {
+            request.promise.set_exception(error);
+        } else {
+            request.promise.set_value();
+        }
+    }
+
+    void drain(Lane& lane) const {
+        std::vector<Request> batch;
+        std::vector<float> amounts;
+        batch.reserve(maxBatch);
+        amounts.reserve(maxBatch);
+        while (lane.queue.popBatch(batch, maxBatch)) {
+            for (const Request& request : batch) {
+                amounts.push_back(request.amount);
+            }
+            std::exception_ptr error;
+            try {
+                lane.strategy->payBatch(amounts);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            for (Request& request : batch) {
+                complete(request, error);
+            }
+            batch.clear();
+            amounts.clear();
+        }
+    }
+
+    Lane& laneFor(StrategyId id) {
+        if (id >= lanes.size()) {
+            throw std::out_of_range("PaymentPipeline: unknown strategy id");
+        }
+        return *lanes[id];
+    }
+
+public:
+    explicit PaymentPipeline(std::size_t capacityPerStrategy = 1024, std::size_t batchSize = 256)
+        : queueCapacity(capacityPerStrategy), maxBatch(std::max<std::size_t>(batchSize, 1)) {}
+
+    PaymentPipeline(const PaymentPipeline&) = delete;
+    PaymentPipeline& operator=(const PaymentPipeline&) = delete;
+
+    ~PaymentPipeline() {
+        shutdown();
+    }
+
+    // Registers a strategy and starts its worker; payments for it are submitted with the returned id.
+    // Register every strategy before submitting from several threads.
+    StrategyId addStrategy(std::shared_ptr<PaymentStrategy> strategy) {
+        lanes.push_back(std::make_unique<Lane>(std::move(strategy), queueCapacity));
+        Lane& lane = *lanes.back();
+        lane.worker = std::thread([this, &lane] { drain(lane); });
+        return lanes.size() - 1;
+    }
+
+    // Queues a payment and returns a future that is ready once it has been processed
+    std::future<void> submit(StrategyId id, float amount) {
+        Request request{amount, std::promise<void>(), Completion()};
+        std::future<void> done = request.promise.get_future();
+        if (!laneFor(id).queue.push(std::move(request))) {
+            throw std::runtime_error("PaymentPipeline: pipeline is shut down");
+        }
+        return done;
+    }
+
+    // Queues a payment and calls completion on the worker thread once it has been processed
+    void submit(StrategyId id, float amount, Completion completion) {
+        if (!laneFor(id).queue.push(Request{amount, std::promise<void>(), std::move(completion)})) {
+            throw std::runtime_error("PaymentPipeline: pipeline is shut down");
+        }
+    }
+
+    // Finishes every queued payment and stops the workers
+    void shutdown() {
+        for (auto& lane : lanes) {
+            lane->queue.close();
+        }
+        for (auto& lane : lanes) {
+            if (lane->worker.joinable()) {
+                lane->worker.join();
+            }
+        }
+    }
+};
@@ -26,91 +26,92 @@ Explanation:
 
 - Client (Main Function): The client creates a ConcreteHouseBuilder and uses the Director to control the building process.
   After construction, the client retrieves the House and displays its properties.
-*/
-#include <iostream>
-#include <string>
-
-// The Product class: represents the complex object to be built
-class House {
-private:
-    std::string windows;
-    std::string doors;
-    std::string rooms;
-
-public:
-    void setWindows(const std::string& windows) {
-        this->windows = windows;
-    }
-
-    void setDoors(const std::string& doors) {
-        this->doors = doors;
-    }
-
-    void setRooms(const std::string& rooms) {
-        this->rooms = rooms;
-    }
 
-    void showHouse() const {
-        std::cout << "House with: " << windows << ", " << doors << ", " << rooms << std::endl;
-    }
-};
-
-// The Builder class: provides an interface to build parts of the object
-class HouseBuilder {
-protected:
-    House* house;  // The product being built
-
-public:
-    HouseBuilder() {
-        house = new House();
-    }
-
-    virtual ~HouseBuilder() {
-        delete house;
-    }
-
-    House* getHouse() {
-        return house;
-    }
-
-    virtual void buildWindows() = 0;
-    virtual void buildDoors() = 0;
-    virtual void buildRooms() = 0;
-};
+Fluent Value Builder:
+The classic builder allocates the House with new, hands out a raw House* owned by the builder, and goes through
+three virtual build*() calls that each copy a std::string. FluentHouseBuilder is a value-semantic alternative:
+- FluentHouseBuilder{}.windows(...).doors(...).rooms(...).build() chains on a temporary, moving every string
+  into the builder and then into the product.
+- build() returns House by value, so the House is constructed directly in the caller's storage (NRVO);
+  nothing is allocated for the House itself.
+- HouseRecipe holds std::string_view parts and is fully constexpr, so literal configurations can be written
+  once at compile time and turned into Houses with recipe.build().
+
+Batch Construction (BatchDirector):
+Director::constructHouse() builds one product on one thread. BatchDirector materializes a whole batch from a
+recipe: it sizes one contiguous std::vector<House> up front, splits the index range into one slice per worker
+thread, and each worker fills its slice in place with its own FluentHouseBuilder. Workers never share a builder
+or write to the same element, so no locking is needed; an exception thrown by a worker is rethrown to the caller.
+- House stores std::pmr::string parts. Each worker builds into its own std::pmr::monotonic_buffer_resource, sized
+  up front for its whole slice, so a batch costs one upstream allocation per worker instead of one malloc per long
+  part, and workers never meet in the global allocator.
+- The result is a HouseBatch that owns the arenas next to the contiguous std::vector<House>, so the strings stay
+  valid exactly as long as the houses. Access is read-only: moving a House out would leave it pointing into an
+  arena the batch frees.
+- If a worker thread cannot be started, the threads already running are joined before the error propagates.
+*/
+#include "builder.h"
 
-// A concrete builder: implements the steps defined in the builder interface
-class ConcreteHouseBuilder : public HouseBuilder {
-public:
-    void buildWindows() override {
-        house->setWindows("4 large windows");
-    }
+#include "counting_allocator.h"
 
-    void buildDoors() override {
-        house->setDoors("2 wooden doors");
-    }
+#include <chrono>
+#include <cstdint>
+#include <iostream>
 
-    void buildRooms() override {
-        house->setRooms("3 spacious rooms");
+// Builds count houses through one path and reports ns and heap allocations per house
+template <typename BuildHouse>
+void measureBuildPath(const char* name, std::size_t count, BuildHouse buildHouse) {
+    std::size_t allocationsBefore = heapAllocationCount();
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        buildHouse();
     }
-};
+    auto end = std::chrono::steady_clock::now();
 
-// The Director class: controls the building process (optional)
-class Director {
-private:
-    HouseBuilder* builder;
+    double houses = static_cast<double>(count);
+    std::cout << name << std::chrono::duration<double, std::nano>(end - begin).count() / houses << " ns/house, "
+              << static_cast<double>(heapAllocationCount() - allocationsBefore) / houses << " allocations/house\n";
+}
 
-public:
-    void setBuilder(HouseBuilder* builder) {
-        this->builder = builder;
-    }
+void runBuilderBenchmark() {
+    const std::size_t count = 1'000'000;
+    volatile std::size_t sink = 0;
+
+    std::cout << "\nBuilding " << count << " houses:\n";
+    measureBuildPath("Director + ConcreteHouseBuilder: ", count, [&]() {
+        ConcreteHouseBuilder builder;
+        Director director;
+        director.setBuilder(&builder);
+        director.constructHouse();
+        sink = sink + reinterpret_cast<std::uintptr_t>(builder.getHouse()) % 2;
+    });
+    measureBuildPath("FluentHouseBuilder (temporary):  ", count, [&]() {
+        House house = FluentHouseBuilder{}.windows("4 large windows").doors("2 wooden doors").rooms("3 spacious rooms").build();
+        sink = sink + reinterpret_cast<std::uintptr_t>(&house) % 2;
+    });
+    measureBuildPath("constexpr HouseRecipe:           ", count, [&]() {
+        House house = familyHouse.build();
+        sink = sink + reinterpret_cast<std::uintptr_t>(&house) % 2;
+    });
+}
 
-    // Directs the builder to construct the house step by step
-    void constructHouse() {
-        builder->buildWindows();
-        builder->buildDoors();
-        builder->buildRooms();
+// Startup time of a large batch as the number of workers grows
+void runBatchBenchmark() {
+    const std::size_t count = 200'000;
+    unsigned maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "\nBatchDirector building " << count << " houses:\n";
+    std::cout << "workers\tms\theap allocations\n";
+    for (unsigned workers = 1; workers <= maxWorkers; workers *= 2) {
+        BatchDirector director(workers);
+        std::size_t allocationsBefore = heapAllocationCount();
+        auto begin = std::chrono::steady_clock::now();
+        HouseBatch houses = director.constructHouses(familyHouse, count);
+        auto end = std::chrono::steady_clock::now();
+        std::cout << workers << '\t' << std::chrono::duration<double, std::milli>(end - begin).count() << '\t'
+                  << heapAllocationCount() - allocationsBefore << '\n';
     }
-};
+}
 
 // Example to build it with director
 void buildWithDirector() {
@@ -149,6 +150,25 @@ int main() {
     buildWithDirector();
     buildWithoutDirector();
 
+    // Fluent value builder: the House lives on the stack, strings are moved in
+    House house = FluentHouseBuilder{}.windows("6 tall windows").doors("1 glass door").rooms("4 bright rooms").build();
+    house.showHouse();
+
+    // Literal configurations resolved at compile time
+    cottage.build().showHouse();
+    FluentHouseBuilder(familyHouse).doors("3 oak doors").build().showHouse();
+
+    // Batch construction on several threads into one contiguous vector
+    BatchDirector batchDirector;
+    HouseBatch street = batchDirector.constructHouses(cottage, 3);
+    for (const House& streetHouse : street) {
+        streetHouse.showHouse();
+    }
+
+    flushEvents();  // The benchmarks print to std::cout directly
+    runBuilderBenchmark();
+    runBatchBenchmark();
+
 
     return 0;
 }
@@ -0,0 +1,268 @@
+// Builder pattern classes. builder.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// The Product class: represents the complex object to be built. The parts are pmr strings, so a batch can place
+// them in an arena; by default they use the global heap like std::string.
+class House {
+private:
+    std::pmr::string windows;
+    std::pmr::string doors;
+    std::pmr::string rooms;
+
+public:
+    House() = default;
+
+    // Takes the parts by value so callers can move them in; each part keeps its own memory resource
+    House(std::pmr::string windows, std::pmr::string doors, std::pmr::string rooms)
+        : windows(std::move(windows)), doors(std::move(doors)), rooms(std::move(rooms)) {}
+
+    void setWindows(std::string_view windows) {
+        this->windows = windows;
+    }
+
+    void setDoors(std::string_view doors) {
+        this->doors = doors;
+    }
+
+    void setRooms(std::string_view rooms) {
+        this->rooms = rooms;
+    }
+
+    void showHouse() const {
+        logEvent<LogLevel::Info>("House with: ", windows, ", ", doors, ", ", rooms);
+    }
+};
+
+// The Builder class: provides an interface to build parts of the object
+class HouseBuilder {
+protected:
+    House* house;  // The product being built
+
+public:
+    HouseBuilder() {
+        house = new House();
+    }
+
+    virtual ~HouseBuilder() {
+        delete house;
+    }
+
+    House* getHouse() {
+        return house;
+    }
+
+    virtual void buildWindows() = 0;
+    virtual void buildDoors() = 0;
+    virtual void buildRooms() = 0;
+};
+
+// A concrete builder: implements the steps defined in the builder interface
+class ConcreteHouseBuilder : public HouseBuilder {
+public:
+    void buildWindows() override {
+        house->setWindows("4 large windows");
+    }
+
+    void buildDoors() override {
+        house->setDoors("2 wooden doors");
+    }
+
+    void buildRooms() override {
+        house->setRooms("3 spacious rooms");
+    }
+};
+
+// The Director class: controls the building process (optional)
+class Director {
+private:
+    HouseBuilder* builder;
+
+public:
+    void setBuilder(HouseBuilder* builder) {
+        this->builder = builder;
+    }
+
+    // Directs the builder to construct the house step by step
+    void constructHouse() {
+        builder->buildWindows();
+        builder->buildDoors();
+        builder->buildRooms();
+    }
+};
+
+// Literal house configuration: only views, so it can be built and stored at compile time
+class HouseRecipe {
+private:
+    std::string_view windowsPart;
+    std::string_view doorsPart;
+    std::string_view roomsPart;
+
+public:
+    constexpr HouseRecipe() = default;
+    constexpr HouseRecipe(std::string_view windows, std::string_view doors, std::string_view rooms)
+        : windowsPart(windows), doorsPart(doors), roomsPart(rooms) {}
+
+    constexpr HouseRecipe withWindows(std::string_view windows) const { return {windows, doorsPart, roomsPart}; }
+    constexpr HouseRecipe withDoors(std::string_view doors) const { return {windowsPart, doors, roomsPart}; }
+    constexpr HouseRecipe withRooms(std::string_view rooms) const { return {windowsPart, doorsPart, rooms}; }
+
+    constexpr std::string_view windows() const { return windowsPart; }
+    constexpr std::string_view doors() const { return doorsPart; }
+    constexpr std::string_view rooms() const { return roomsPart; }
+
+    // Materializes the House; the only allocations are the strings that do not fit the small-string buffer, made
+    // from `resource`
+    House build(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const {
+        return House(std::pmr::string(windowsPart, resource), std::pmr::string(doorsPart, resource),
+                     std::pmr::string(roomsPart, resource));
+    }
+
+    // Bytes needed to build one House from `resource`, terminators included
+    constexpr std::size_t bytes() const { return windowsPart.size() + doorsPart.size() + roomsPart.size() + 3; }
+};
+
+// Value-semantic fluent builder: no heap House, no virtual calls, strings are moved rather than copied
+class FluentHouseBuilder {
+private:
+    std::pmr::string windowsPart;
+    std::pmr::string doorsPart;
+    std::pmr::string roomsPart;
+
+public:
+    FluentHouseBuilder() = default;
+
+    // Starts from a literal recipe
+    explicit FluentHouseBuilder(const HouseRecipe& recipe)
+        : windowsPart(recipe.windows()), doorsPart(recipe.doors()), roomsPart(recipe.rooms()) {}
+
+    // Chaining on a named builder
+    FluentHouseBuilder& windows(std::pmr::string value) & {
+        windowsPart = std::move(value);
+        return *this;
+    }
+
+    FluentHouseBuilder& doors(std::pmr::string value) & {
+        doorsPart = std::move(value);
+        return *this;
+    }
+
+    FluentHouseBuilder& rooms(std::pmr::string value) & {
+        roomsPart = std::move(value);
+        return *this;
+    }
+
+    // Chaining on a temporary: FluentHouseBuilder{}.windows(...).doors(...).build()
+    FluentHouseBuilder&& windows(std::pmr::string value) && { return std::move(windows(std::move(value))); }
+    FluentHouseBuilder&& doors(std::pmr::string value) && { return std::move(doors(std::move(value))); }
+    FluentHouseBuilder&& rooms(std::pmr::string value) && { return std::move(rooms(std::move(value))); }
+
+    // A named builder can be reused, so its parts are copied into the House
+    House build() const& {
+        return House(windowsPart, doorsPart, roomsPart);
+    }
+
+    // A temporary builder gives its parts away
+    House build() && {
+        return House(std::move(windowsPart), std::move(doorsPart), std::move(roomsPart));
+    }
+
+    // Copies the parts into a House whose strings live in `resource`
+    House build(std::pmr::memory_resource* resource) const {
+        return House(std::pmr::string(windowsPart, resource), std::pmr::string(doorsPart, resource),
+                     std::pmr::string(roomsPart, resource));
+    }
+};
+
+// Configurations known at compile time
+constexpr HouseRecipe familyHouse{"4 large windows", "2 wooden doors", "3 spacious rooms"};
+constexpr HouseRecipe cottage = familyHouse.withWindows("2 small windows").withRooms("1 cozy room");
+
+// Houses built by BatchDirector, together with the per-worker arenas their strings live in
+class HouseBatch {
+private:
+    std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> arenas;  // Declared first so it outlives houses
+    std::vector<House> houses;
+
+    friend class BatchDirector;
+
+public:
+    HouseBatch() = default;
+
+    std::size_t size() const { return houses.size(); }
+    const House& operator[](std::size_t index) const { return houses[index]; }
+    std::vector<House>::const_iterator begin() const { return houses.begin(); }
+    std::vector<House>::const_iterator end() const { return houses.end(); }
+};
+
+// Director for large batches: splits the construction of count houses across worker threads
+class BatchDirector {
+private:
+    unsigned workerCount;
+
+public:
+    explicit BatchDirector(unsigned workers = std::thread::hardware_concurrency())
+        : workerCount(std::max(1u, workers)) {}
+
+    HouseBatch constructHouses(const HouseRecipe& recipe, std::size_t count) const {
+        HouseBatch batch;
+        batch.houses.resize(count);  // Empty Houses, replaced in place by the workers
+        std::size_t workers = std::min<std::size_t>(workerCount, std::max<std::size_t>(count, 1));
+        std::size_t sliceSize = (count + workers - 1) / workers;
+        for (std::size_t worker = 0; worker < workers; ++worker) {  // Sized for the whole slice: one upstream block
+            batch.arenas.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>(sliceSize * recipe.bytes()));
+        }
+        std::vector<std::exception_ptr> errors(workers);
+        std::vector<std::thread> threads;
+        threads.reserve(workers);
+
+        try {
+            for (std::size_t worker = 0; worker < workers; ++worker) {
+                std::size_t first = std::min(count, worker * sliceSize);
+                std::size_t last = std::min(count, first + sliceSize);
+                std::pmr::memory_resource* arena = batch.arenas[worker].get();
+                threads.emplace_back([&batch, &errors, &recipe, arena, worker, first, last]() {
+                    try {
+                        FluentHouseBuilder builder(recipe);  // One builder per worker
+                        for (std::size_t i = first; i < last; ++i) {
+                            // Move assignment would copy the strings back to the default resource, so the
+                            // element is replaced instead; only the noexcept move can run after destroy_at
+                            House house = builder.build(arena);
+                            std::destroy_at(&batch.houses[i]);
+                            std::construct_at(&batch.houses[i], std::move(house));
+                        }
+                    } catch (...) {
+                        errors[worker] = std::current_exception();
+                    }
+                });
+            }
+        } catch (...) {
+            for (auto& thread : threads) {  // A thread failed to start: wait for the ones that did
+                thread.join();
+            }
+            throw;
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+        return batch;
+    }
+};
@@ -37,56 +37,137 @@ Advantages of Factory Method Pattern:
 - Flexibility: You can add new product types (e.g., Truck, Bus) without modifying the client code,
   simply by adding new factories.
 
+Compile-Time Factory (StaticVehicleFactory):
+The classic form needs one factory subclass per product, heap-allocates both the factory and the product,
+and pays a virtual createVehicle() call for every object. When the set of products is closed and objects are
+built from type tags at a high rate, StaticVehicleFactory<Car, Bike, Truck> replaces the hierarchy:
+- Tags are indices into the product list (tagOf<Car>() is a compile-time constant).
+- A constexpr jump table maps each tag to a function that emplaces that product into a std::variant.
+  A tag outside the table throws std::out_of_range instead of calling through a garbage pointer.
+- Products are built in place into caller-provided storage (a std::variant slot), so there is no factory object,
+  no heap allocation and no virtual call on the create path.
+- std::visit gives access to the concrete product, so calls on it can be resolved statically as well.
+
+Pooled Factory Mode (memory_resource):
+createVehicle() returns std::make_unique<Car>(), i.e. one malloc per object, and at high allocation rates the
+allocator lock dominates. Every factory therefore also accepts a std::pmr::memory_resource:
+- createVehicle(resource) returns a PooledVehicle, a unique_ptr whose PooledVehicleDeleter destroys the product and
+  hands its slot back to the resource. With a std::pmr::unsynchronized_pool_resource (per-size free lists) the slot is
+  recycled by the next create, so steady state needs no calls into malloc at all.
+- createVehicles(n, resource) builds n products in one contiguous VehicleBlock with a single allocation.
+Use std::pmr::synchronized_pool_resource instead when several threads share one resource.
+
+Reporting (instrumentation.h):
+showDetails() used to print with std::cout << ... << std::endl, a flushed write that every thread waits for.
+It now logs through the shared instrumentation layer:
+- The message goes into a ring owned by the calling thread, and a background thread prints it.
+- A CallSite per product counts the calls and records their latency and heap allocations (the counting
+  operator new from counting_allocator.cpp feeds countAllocation()).
+main() prints the collected numbers with writeJson(); writePrometheus() exports them in the Prometheus text format.
+
 */
+#include "factory.h"
+
+#include "counting_allocator.h"
+
+#include <chrono>
+#include <cstdint>
 #include <iostream>
-#include <memory>  // For using smart pointers
-
-// The Product interface
-class Vehicle {
-public:
-    virtual void showDetails() const = 0;  // Pure virtual method
-    virtual ~Vehicle() = default;  // Virtual destructor
-};
-
-// ConcreteProduct: Car
-class Car : public Vehicle {
-public:
-    void showDetails() const override {
-        std::cout << "This is a Car." << std::endl;
+#include <vector>
+
+// Compares the virtual factory hierarchy with the compile-time table for the same sequence of tags
+void runFactoryBenchmark() {
+    const std::size_t count = 5'000'000;
+
+    // Pseudo-random tags so the branch predictor cannot learn a fixed pattern
+    std::vector<std::uint8_t> tags(count);
+    std::uint32_t seed = 12345;
+    for (auto& tag : tags) {
+        seed = seed * 1664525u + 1013904223u;
+        tag = static_cast<std::uint8_t>((seed >> 16) % VehicleTable::productCount);
     }
-};
 
-// ConcreteProduct: Bike
-class Bike : public Vehicle {
-public:
-    void showDetails() const override {
-        std::cout << "This is a Bike." << std::endl;
+    std::vector<std::unique_ptr<VehicleFactory>> factories;
+    factories.push_back(std::make_unique<CarFactory>());
+    factories.push_back(std::make_unique<BikeFactory>());
+    factories.push_back(std::make_unique<TruckFactory>());
+
+    std::uintptr_t checksum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (std::uint8_t tag : tags) {
+        std::unique_ptr<Vehicle> vehicle = factories[tag]->createVehicle();
+        checksum += reinterpret_cast<std::uintptr_t>(vehicle.get()) & 0xff;
     }
-};
-
-// The Creator (Factory) interface
-class VehicleFactory {
-public:
-    // Factory method to create vehicles (pure virtual)
-    virtual std::unique_ptr<Vehicle> createVehicle() const = 0;
-    virtual ~VehicleFactory() = default;
-};
-
-// ConcreteCreator: CarFactory
-class CarFactory : public VehicleFactory {
-public:
-    std::unique_ptr<Vehicle> createVehicle() const override {
-        return std::make_unique<Car>();  // Return a Car instance
+    auto end = std::chrono::steady_clock::now();
+    double virtualNs = std::chrono::duration<double, std::nano>(end - begin).count() / count;
+
+    // Caller-provided storage, reused for every batch
+    std::vector<VehicleTable::Product> storage(count);
+    begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        checksum += VehicleTable::create(tags[i], storage[i]).index();
     }
-};
+    end = std::chrono::steady_clock::now();
+    double staticNs = std::chrono::duration<double, std::nano>(end - begin).count() / count;
+
+    std::cout << "\nCreating " << count << " vehicles from tags:\n";
+    std::cout << "virtual factory hierarchy: " << virtualNs << " ns/create\n";
+    std::cout << "static jump table:         " << staticNs << " ns/create\n";
+    std::cout << "(checksum " << checksum << ")\n";
+}
 
-// ConcreteCreator: BikeFactory
-class BikeFactory : public VehicleFactory {
-public:
-    std::unique_ptr<Vehicle> createVehicle() const override {
-        return std::make_unique<Bike>();  // Return a Bike instance
+// Creates and drops batches of vehicles through one create path, reporting ns per create and heap allocations per object
+template <typename CreateBatch>
+void measureCreatePath(const char* name, std::size_t rounds, std::size_t batch, CreateBatch createBatch) {
+    std::size_t allocationsBefore = heapAllocationCount();
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        createBatch(batch);
     }
-};
+    auto end = std::chrono::steady_clock::now();
+    std::size_t allocations = heapAllocationCount() - allocationsBefore;
+
+    double objects = static_cast<double>(rounds * batch);
+    std::cout << name << std::chrono::duration<double, std::nano>(end - begin).count() / objects << " ns/create, "
+              << static_cast<double>(allocations) / objects << " allocations/object\n";
+}
+
+// Compares the classic make_unique path with the pooled and bulk memory_resource paths
+void runAllocationBenchmark() {
+    const std::size_t rounds = 2'000;
+    const std::size_t batch = 1'000;
+
+    CarFactory carFactory;
+    BikeFactory bikeFactory;
+    TruckFactory truckFactory;
+    const VehicleFactory* factories[] = {&carFactory, &bikeFactory, &truckFactory};
+
+    std::cout << "\nCreating " << rounds << " batches of " << batch << " vehicles:\n";
+
+    std::vector<std::unique_ptr<Vehicle>> classic;
+    classic.reserve(batch);
+    measureCreatePath("make_unique:             ", rounds, batch, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            classic.push_back(factories[i % 3]->createVehicle());
+        }
+        classic.clear();
+    });
+
+    std::pmr::unsynchronized_pool_resource pool;
+    std::vector<PooledVehicle> pooled;
+    pooled.reserve(batch);
+    measureCreatePath("pool_resource:           ", rounds, batch, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            pooled.push_back(factories[i % 3]->createVehicle(&pool));
+        }
+        pooled.clear();  // Slots go back to the pool's free lists and are reused by the next round
+    });
+
+    measureCreatePath("createVehicles(n) block: ", rounds, batch, [&](std::size_t n) {
+        VehicleBlock block = carFactory.createVehicles(n, &pool);
+        (void)block;
+    });
+}
 
 int main() {
     // Create a Car factory
@@ -101,29 +182,29 @@ int main() {
     std::unique_ptr<Vehicle> bike = bikeFactory->createVehicle();
     bike->showDetails();  // Output: This is a Bike.
 
-    return 0;
-}
+    // Same products through the compile-time factory: no factory object, no heap allocation
+    VehicleTable::Product vehicle = VehicleTable::create(VehicleTable::tagOf<Truck>());
+    showDetails(vehicle);  // Output: This is a Truck.
 
+    VehicleTable::create(VehicleTable::tagOf<Car>(), vehicle);  // Rebuild in place into the same storage
+    showDetails(vehicle);  // Output: This is a Car.
 
-/*
-Example of Extending the Pattern:
-If you want to add a Truck, you would:
+    // Pooled mode: slots come from a pool and are recycled when the handles go away
+    std::pmr::unsynchronized_pool_resource pool;
+    PooledVehicle pooledBike = bikeFactory->createVehicle(&pool);
+    pooledBike->showDetails();  // Output: This is a Bike.
 
-- Create a Truck class that inherits from Vehicle.
-- Create a TruckFactory class that inherits from VehicleFactory and implements the createVehicle() method.
-*/
-// ConcreteProduct: Truck
-class Truck : public Vehicle {
-public:
-    void showDetails() const override {
-        std::cout << "This is a Truck." << std::endl;
+    VehicleBlock cars = carFactory->createVehicles(3, &pool);  // Three cars in one contiguous block
+    for (std::size_t i = 0; i < cars.size(); ++i) {
+        cars[i].showDetails();  // Output: This is a Car.
     }
-};
 
-// ConcreteCreator: TruckFactory
-class TruckFactory : public VehicleFactory {
-public:
-    std::unique_ptr<Vehicle> createVehicle() const override {
-        return std::make_unique<Truck>();  // Return a Truck instance
-    }
-};
+    // Per-call-site metrics for the calls above, once their events have been printed
+    flushEvents();
+    writeJson(std::cout);
+
+    runFactoryBenchmark();
+    runAllocationBenchmark();
+
+    return 0;
+}
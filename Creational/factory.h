@@ -0,0 +1,299 @@
+// Factory pattern classes. factory.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include "instrumentation.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>  // For using smart pointers
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+// The Product interface
+class Vehicle {
+public:
+    virtual void showDetails() const = 0;  // Pure virtual method
+    virtual ~Vehicle() = default;  // Virtual destructor
+};
+
+// ConcreteProduct: Car
+class Car : public Vehicle {
+public:
+    void showDetails() const override {
+        static CallSite site("Car::showDetails");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("This is a Car.");
+    }
+};
+
+// ConcreteProduct: Bike
+class Bike : public Vehicle {
+public:
+    void showDetails() const override {
+        static CallSite site("Bike::showDetails");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("This is a Bike.");
+    }
+};
+
+// Deleter that destroys a vehicle and returns its slot to the memory_resource it came from
+class PooledVehicleDeleter {
+private:
+    std::pmr::memory_resource* resource = nullptr;
+    std::size_t size = 0;
+    std::size_t alignment = 0;
+
+public:
+    PooledVehicleDeleter() = default;
+    PooledVehicleDeleter(std::pmr::memory_resource* resource, std::size_t size, std::size_t alignment)
+        : resource(resource), size(size), alignment(alignment) {}
+
+    void operator()(Vehicle* vehicle) const {
+        vehicle->~Vehicle();
+        resource->deallocate(vehicle, size, alignment);
+    }
+};
+
+using PooledVehicle = std::unique_ptr<Vehicle, PooledVehicleDeleter>;
+
+// Builds one Product in memory taken from resource
+template <typename Product>
+PooledVehicle makePooledVehicle(std::pmr::memory_resource* resource) {
+    void* slot = resource->allocate(sizeof(Product), alignof(Product));
+    try {
+        Product* product = ::new (slot) Product();
+        return PooledVehicle(product, PooledVehicleDeleter(resource, sizeof(Product), alignof(Product)));
+    } catch (...) {
+        resource->deallocate(slot, sizeof(Product), alignof(Product));
+        throw;
+    }
+}
+
+// A contiguous block of vehicles of one type, created and released with a single allocation
+class VehicleBlock {
+private:
+    using View = Vehicle* (*)(std::byte*);
+    using Destroy = void (*)(std::byte*, std::size_t);
+
+    std::pmr::memory_resource* resource = nullptr;
+    std::byte* storage = nullptr;
+    std::size_t count = 0;
+    std::size_t stride = 0;
+    std::size_t alignment = 0;
+    View view = nullptr;
+    Destroy destroy = nullptr;
+
+    void release() {
+        if (storage != nullptr) {
+            destroy(storage, count);
+            resource->deallocate(storage, count * stride, alignment);
+            storage = nullptr;
+        }
+    }
+
+    VehicleBlock(std::pmr::memory_resource* resource, std::byte* storage, std::size_t count, std::size_t stride,
+                 std::size_t alignment, View view, Destroy destroy)
+        : resource(resource), storage(storage), count(count), stride(stride), alignment(alignment),
+          view(view), destroy(destroy) {}
+
+    template <typename Product>
+    friend VehicleBlock makeVehicleBlock(std::size_t count, std::pmr::memory_resource* resource);
+
+public:
+    VehicleBlock() = default;
+
+    VehicleBlock(VehicleBlock&& other) noexcept { *this = std::move(other); }
+
+    VehicleBlock& operator=(VehicleBlock&& other) noexcept {
+        if (this != &other) {
+            release();
+            resource = other.resource;
+            storage = std::exchange(other.storage, nullptr);
+            count = std::exchange(other.count, 0);
+            stride = other.stride;
+            alignment = other.alignment;
+            view = other.view;
+            destroy = other.destroy;
+        }
+        return *this;
+    }
+
+    ~VehicleBlock() { release(); }
+
+    std::size_t size() const { return count; }
+
+    Vehicle& operator[](std::size_t index) const { return *view(storage + index * stride); }
+};
+
+// Builds count Products back to back in one allocation taken from resource
+template <typename Product>
+VehicleBlock makeVehicleBlock(std::size_t count, std::pmr::memory_resource* resource) {
+    auto view = [](std::byte* slot) -> Vehicle* { return std::launder(reinterpret_cast<Product*>(slot)); };
+    auto destroy = [](std::byte* first, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::launder(reinterpret_cast<Product*>(first + i * sizeof(Product)))->~Product();
+        }
+    };
+
+    auto* storage = static_cast<std::byte*>(resource->allocate(count * sizeof(Product), alignof(Product)));
+    std::size_t built = 0;
+    try {
+        for (; built < count; ++built) {
+            ::new (storage + built * sizeof(Product)) Product();
+        }
+    } catch (...) {
+        destroy(storage, built);
+        resource->deallocate(storage, count * sizeof(Product), alignof(Product));
+        throw;
+    }
+    return VehicleBlock(resource, storage, count, sizeof(Product), alignof(Product), view, destroy);
+}
+
+// The Creator (Factory) interface
+class VehicleFactory {
+public:
+    // Factory method to create vehicles (pure virtual)
+    virtual std::unique_ptr<Vehicle> createVehicle() const = 0;
+    // Pooled mode: the vehicle lives in memory taken from resource and goes back there when the handle is dropped
+    virtual PooledVehicle createVehicle(std::pmr::memory_resource* resource) const = 0;
+    // Bulk mode: n vehicles in one contiguous block
+    virtual VehicleBlock createVehicles(std::size_t n, std::pmr::memory_resource* resource) const = 0;
+    virtual ~VehicleFactory() = default;
+};
+
+// ConcreteCreator: CarFactory
+class CarFactory : public VehicleFactory {
+public:
+    std::unique_ptr<Vehicle> createVehicle() const override {
+        return std::make_unique<Car>();  // Return a Car instance
+    }
+
+    PooledVehicle createVehicle(std::pmr::memory_resource* resource) const override {
+        return makePooledVehicle<Car>(resource);
+    }
+
+    VehicleBlock createVehicles(std::size_t n, std::pmr::memory_resource* resource) const override {
+        return makeVehicleBlock<Car>(n, resource);
+    }
+};
+
+// ConcreteCreator: BikeFactory
+class BikeFactory : public VehicleFactory {
+public:
+    std::unique_ptr<Vehicle> createVehicle() const override {
+        return std::make_unique<Bike>();  // Return a Bike instance
+    }
+
+    PooledVehicle createVehicle(std::pmr::memory_resource* resource) const override {
+        return makePooledVehicle<Bike>(resource);
+    }
+
+    VehicleBlock createVehicles(std::size_t n, std::pmr::memory_resource* resource) const override {
+        return makeVehicleBlock<Bike>(n, resource);
+    }
+};
+
+/*
+Example of Extending the Pattern:
+If you want to add a Truck, you would:
+
+- Create a Truck class that inherits from Vehicle.
+- Create a TruckFactory class that inherits from VehicleFactory and implements the createVehicle() methods
+  (the pooled overloads are one line each thanks to makePooledVehicle<Truck>() and makeVehicleBlock<Truck>()).
+*/
+// ConcreteProduct: Truck
+class Truck : public Vehicle {
+public:
+    void showDetails() const override {
+        static CallSite site("Truck::showDetails");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("This is a Truck.");
+    }
+};
+
+// ConcreteCreator: TruckFactory
+class TruckFactory : public VehicleFactory {
+public:
+    std::unique_ptr<Vehicle> createVehicle() const override {
+        return std::make_unique<Truck>();  // Return a Truck instance
+    }
+
+    PooledVehicle createVehicle(std::pmr::memory_resource* resource) const override {
+        return makePooledVehicle<Truck>(resource);
+    }
+
+    VehicleBlock createVehicles(std::size_t n, std::pmr::memory_resource* resource) const override {
+        return makeVehicleBlock<Truck>(n, resource);
+    }
+};
+
+// Compile-time factory: resolves a tag to a product through a constexpr jump table
+template <typename... Products>
+class StaticVehicleFactory {
+public:
+    using Product = std::variant<Products...>;
+    static constexpr std::size_t productCount = sizeof...(Products);
+
+private:
+    using Emplacer = void (*)(Product&);
+
+    template <std::size_t Index>
+    static void emplaceAt(Product& storage) {
+        storage.template emplace<Index>();
+    }
+
+    template <std::size_t... Indices>
+    static constexpr auto makeTable(std::index_sequence<Indices...>) {
+        return std::array<Emplacer, productCount>{&emplaceAt<Indices>...};
+    }
+
+    static constexpr std::array<Emplacer, productCount> table = makeTable(std::index_sequence_for<Products...>{});
+
+    template <typename Wanted, std::size_t Index, typename First, typename... Rest>
+    static constexpr std::size_t indexOf() {
+        if constexpr (std::is_same_v<Wanted, First>) {
+            return Index;
+        } else {
+            static_assert(sizeof...(Rest) > 0, "Product is not registered in this factory");
+            return indexOf<Wanted, Index + 1, Rest...>();
+        }
+    }
+
+public:
+    // Tag of a registered product, usable as a compile-time constant
+    template <typename Wanted>
+    static constexpr std::size_t tagOf() {
+        return indexOf<Wanted, 0, Products...>();
+    }
+
+    // Builds the product for tag in place into caller-provided storage; throws std::out_of_range for an unknown tag
+    static Product& create(std::size_t tag, Product& storage) {
+        if (tag >= productCount) {
+            throw std::out_of_range("unknown vehicle tag " + std::to_string(tag));
+        }
+        table[tag](storage);
+        return storage;
+    }
+
+    // Builds the product for tag and returns it by value
+    static Product create(std::size_t tag) {
+        Product product;
+        create(tag, product);
+        return product;
+    }
+
+    StaticVehicleFactory() = delete;
+};
+
+using VehicleTable = StaticVehicleFactory<Car, Bike, Truck>;
+
+// Calls showDetails() on whatever product the variant holds, resolved statically per alternative
+inline void showDetails(const VehicleTable::Product& vehicle) {
+    std::visit([](const auto& concrete) { concrete.showDetails(); }, vehicle);
+}
@@ -42,68 +42,127 @@ Real-World Example:
 - Document Editing Software: When a user creates a new document based on a template, the system often clones a prototype
   document and modifies its content according to the user's preferences.
 
-*/
-#include <iostream>
-#include <memory>  // For smart pointers
-#include <string>
-
-// Prototype interface (declares the clone method)
-class Shape {
-public:
-    virtual std::unique_ptr<Shape> clone() const = 0;
-    virtual void draw() const = 0;
-    virtual ~Shape() = default;
-};
-
-// ConcretePrototype: Circle
-class Circle : public Shape {
-private:
-    int radius;
-    std::string color;
-
-public:
-    Circle(int r, const std::string& c) : radius(r), color(c) {}
-
-    // Implement the clone method
-    std::unique_ptr<Shape> clone() const override {
-        return std::make_unique<Circle>(*this);  // Copy itself
-    }
-
-    // Method to draw the shape (just for demonstration)
-    void draw() const override {
-        std::cout << "Drawing a " << color << " circle with radius " << radius << std::endl;
-    }
+Bulk and Copy-On-Write Cloning:
+clone() returns std::make_unique<Circle>(*this): one heap node per clone plus a deep copy of the color string.
+When tens of thousands of near-identical shapes are stamped out per frame, two additions cut that cost:
+- cloneN(n, out): Writes n clones back to back into a ShapePool, an arena that hands out contiguous blocks,
+  so a whole batch costs one arena allocation instead of n heap nodes.
+- CowCircle and CowSquare (copy-on-write prototypes): Fields such as the color live in a CopyOnWrite<T> handle.
+  Clones share the prototype's value until setColor() is called, which then gives that clone its own copy; a
+  handle that no longer shares its value is written in place. Cloning then costs an atomic reference-count
+  increment (and a decrement when the clone dies) instead of a string copy. That only pays off for values that
+  allocate, like the long color in runCloneBenchmark(): a short color such as "Red" fits the small-string buffer,
+  and there the plain clone() is about twice as fast (BM_Prototype_Classic vs. BM_Prototype_CopyOnWrite).
+
+Prototype Registry:
+Without a registry the client has to keep originalCircle/originalSquare around itself and dynamic_cast every clone
+before it can customize it. PrototypeRegistry stores the prototypes instead:
+- Prototypes are looked up by a compact PrototypeId (an index), not by name.
+- ColorPool interns color names: each distinct name is stored once and shapes keep a small ColorId, so
+  CompactCircle and CompactSquare are trivially copyable and cloning them never allocates a string.
+- cloneAs<Circle>(id) and copyAs<Circle>(id) return the concrete type directly. The registry remembers the type of
+  every entry, so the check is one pointer comparison instead of a dynamic_cast.
 
-    // Method to set a new color (after cloning)
-    void setColor(const std::string& newColor) {
-        color = newColor;
-    }
-};
+*/
+#include "prototype.h"
 
-// ConcretePrototype: Square
-class Square : public Shape {
-private:
-    int side;
-    std::string color;
+#include "counting_allocator.h"
 
-public:
-    Square(int s, const std::string& c) : side(s), color(c) {}
+#include <chrono>
+#include <iostream>
 
-    // Implement the clone method
-    std::unique_ptr<Shape> clone() const override {
-        return std::make_unique<Square>(*this);  // Copy itself
+// Clones a prototype clonesPerFrame times per frame through one clone path and reports throughput and footprint
+template <typename CloneFrame>
+void measureClonePath(const char* name, std::size_t frames, std::size_t clonesPerFrame, CloneFrame cloneFrame) {
+    std::size_t allocationsBefore = heapAllocationCount();
+    std::size_t bytesBefore = heapAllocatedBytes();
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+        cloneFrame(clonesPerFrame);
     }
+    auto end = std::chrono::steady_clock::now();
 
-    // Method to draw the shape
-    void draw() const override {
-        std::cout << "Drawing a " << color << " square with side " << side << std::endl;
-    }
+    double clones = static_cast<double>(frames * clonesPerFrame);
+    std::cout << name << std::chrono::duration<double, std::nano>(end - begin).count() / clones << " ns/clone, "
+              << static_cast<double>(heapAllocationCount() - allocationsBefore) / clones << " allocations/clone, "
+              << static_cast<double>(heapAllocatedBytes() - bytesBefore) / clones << " heap bytes/clone\n";
+}
 
-    // Method to set a new color (after cloning)
-    void setColor(const std::string& newColor) {
-        color = newColor;
-    }
-};
+void runCloneBenchmark() {
+    const std::size_t frames = 100;
+    const std::size_t clonesPerFrame = 10'000;
+    // Long enough to defeat the small-string optimization, like real attribute strings
+    const std::string color = "Deep ocean blue with a metallic finish";
+
+    Circle circle(10, color);
+    CowCircle cowCircle(10, color);
+    std::vector<std::unique_ptr<Shape>> frameShapes;
+    frameShapes.reserve(clonesPerFrame);
+
+    std::cout << "\nCloning " << frames << " frames of " << clonesPerFrame << " circles:\n";
+    measureClonePath("clone():                ", frames, clonesPerFrame, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            frameShapes.push_back(circle.clone());
+        }
+        frameShapes.clear();
+    });
+    measureClonePath("cloneN() into pool:     ", frames, clonesPerFrame, [&](std::size_t n) {
+        ShapePool pool(n * sizeof(Circle));
+        circle.cloneN(n, pool);
+    });
+    measureClonePath("copy-on-write clone():  ", frames, clonesPerFrame, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            frameShapes.push_back(cowCircle.clone());
+        }
+        frameShapes.clear();
+    });
+    measureClonePath("copy-on-write cloneN(): ", frames, clonesPerFrame, [&](std::size_t n) {
+        ShapePool pool(n * sizeof(CowCircle));
+        cowCircle.cloneN(n, pool);
+    });
+}
+
+// Clone-and-customize: classic clone() + dynamic_cast + string color vs registry copyAs() + interned color
+void runRegistryBenchmark() {
+    const std::size_t frames = 100;
+    const std::size_t clonesPerFrame = 10'000;
+    const std::string color = "Deep ocean blue with a metallic finish";
+    const std::string highlight = "Bright highlight orange for selected items";
+
+    std::unique_ptr<Shape> prototype = std::make_unique<Circle>(10, color);
+
+    PrototypeRegistry registry;
+    ColorId baseColor = registry.colors().intern(color);
+    ColorId highlightColor = registry.colors().intern(highlight);
+    PrototypeId circleId = registry.add(CompactCircle(10, baseColor, registry.colors()));
+
+    std::vector<std::unique_ptr<Shape>> classicFrame;
+    classicFrame.reserve(clonesPerFrame);
+    std::vector<CompactCircle> compactFrame;
+    compactFrame.reserve(clonesPerFrame);
+
+    std::cout << "\nClone-and-customize " << frames << " frames of " << clonesPerFrame << " circles:\n";
+    measureClonePath("clone() + dynamic_cast: ", frames, clonesPerFrame, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::unique_ptr<Shape> clone = prototype->clone();
+            if (i % 2 == 0) {
+                dynamic_cast<Circle*>(clone.get())->setColor(highlight);
+            }
+            classicFrame.push_back(std::move(clone));
+        }
+        classicFrame.clear();
+    });
+    measureClonePath("registry copyAs():      ", frames, clonesPerFrame, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            CompactCircle clone = registry.copyAs<CompactCircle>(circleId);
+            if (i % 2 == 0) {
+                clone.setColor(highlightColor);
+            }
+            compactFrame.push_back(clone);
+        }
+        compactFrame.clear();
+    });
+}
 
 // Client code
 int main() {
@@ -120,13 +179,48 @@ int main() {
     dynamic_cast<Square*>(clonedSquare.get())->setColor("Yellow");
 
     // Draw the original and cloned shapes
-    std::cout << "Original shapes:" << std::endl;
+    logEvent<LogLevel::Info>("Original shapes:");
     originalCircle->draw();  // Should be red
     originalSquare->draw();  // Should be blue
 
-    std::cout << "\nCloned and modified shapes:" << std::endl;
+    logEvent<LogLevel::Info>("\nCloned and modified shapes:");
     clonedCircle->draw();  // Should be green
     clonedSquare->draw();  // Should be yellow
 
+    // Bulk clone three circles into contiguous pool storage
+    ShapePool pool;
+    originalCircle->cloneN(3, pool);
+    logEvent<LogLevel::Info>("\nShapes cloned into the pool: ", pool.size());
+    pool.forEach([](const Shape& shape) { shape.draw(); });
+
+    // Copy-on-write clones share the color until one of them changes it
+    CowCircle cowPrototype(10, "Red");
+    CowCircle cowClone = cowPrototype;
+    logEvent<LogLevel::Info>("\nClone shares color before setColor: ", cowClone.sharesColorWith(cowPrototype));
+    cowClone.setColor("Green");
+    logEvent<LogLevel::Info>("Clone shares color after setColor: ", cowClone.sharesColorWith(cowPrototype));
+    cowClone.setColor("Blue");  // The clone owns its color now, so this writes in place
+    cowPrototype.draw();  // Should be red
+    cowClone.draw();  // Should be blue
+
+    // Registry: prototypes by id, interned colors, typed clones without dynamic_cast
+    PrototypeRegistry registry;
+    PrototypeId redCircle = registry.add(CompactCircle(10, registry.colors().intern("Red"), registry.colors()));
+    PrototypeId blueSquare = registry.add(CompactSquare(5, registry.colors().intern("Blue"), registry.colors()));
+
+    std::unique_ptr<CompactCircle> registryCircle = registry.cloneAs<CompactCircle>(redCircle);
+    registryCircle->setColor(registry.colors().intern("Green"));
+    CompactSquare registrySquare = registry.copyAs<CompactSquare>(blueSquare);
+    registrySquare.setColor(registry.colors().intern("Yellow"));
+
+    logEvent<LogLevel::Info>("\nShapes cloned from the registry:");
+    registry.clone(redCircle)->draw();  // Should be red
+    registryCircle->draw();  // Should be green
+    registrySquare.draw();  // Should be yellow
+
+    flushEvents();  // The benchmarks print to std::cout directly
+    runCloneBenchmark();
+    runRegistryBenchmark();
+
     return 0;
 }
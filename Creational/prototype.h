@@ -0,0 +1,404 @@
+// Prototype pattern classes. prototype.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include "instrumentation.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <memory>  // For smart pointers
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class ShapePool;
+
+// Prototype interface (declares the clone method)
+class Shape {
+public:
+    virtual std::unique_ptr<Shape> clone() const = 0;
+    // Bulk clone: appends n copies of this shape to out in one contiguous block
+    virtual void cloneN(std::size_t n, ShapePool& out) const = 0;
+    virtual void draw() const = 0;
+    virtual ~Shape() = default;
+};
+
+// Arena of shapes: every cloneN() call lands in one contiguous block taken from a monotonic buffer
+class ShapePool {
+private:
+    struct Block {
+        std::byte* first;
+        std::size_t count;
+        std::size_t stride;
+        const Shape* (*view)(const std::byte*);
+        void (*destroy)(std::byte*, std::size_t);
+    };
+
+    std::pmr::monotonic_buffer_resource arena;
+    std::vector<Block> blocks;
+    std::size_t shapeCount = 0;
+
+public:
+    explicit ShapePool(std::size_t initialBytes = 64 * 1024) : arena(initialBytes) {}
+
+    ~ShapePool() {
+        for (const Block& block : blocks) {
+            block.destroy(block.first, block.count);
+        }
+    }
+
+    ShapePool(const ShapePool&) = delete;
+    ShapePool& operator=(const ShapePool&) = delete;
+
+    // Copy-constructs n clones of prototype next to each other and returns the first one
+    template <typename Concrete>
+    Concrete* appendCopies(const Concrete& prototype, std::size_t n) {
+        auto destroy = [](std::byte* first, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                std::launder(reinterpret_cast<Concrete*>(first + i * sizeof(Concrete)))->~Concrete();
+            }
+        };
+        auto view = [](const std::byte* slot) -> const Shape* {
+            return std::launder(reinterpret_cast<const Concrete*>(slot));
+        };
+
+        // Grow the block list up front so recording the block below cannot throw after construction
+        if (blocks.size() == blocks.capacity()) {
+            blocks.reserve(blocks.empty() ? 8 : blocks.size() * 2);
+        }
+        auto* first = static_cast<std::byte*>(arena.allocate(n * sizeof(Concrete), alignof(Concrete)));
+        std::size_t built = 0;
+        try {
+            for (; built < n; ++built) {
+                ::new (first + built * sizeof(Concrete)) Concrete(prototype);
+            }
+        } catch (...) {
+            destroy(first, built);  // The arena reclaims the memory when the pool goes away
+            throw;
+        }
+
+        blocks.push_back(Block{first, n, sizeof(Concrete), view, destroy});
+        shapeCount += n;
+        return std::launder(reinterpret_cast<Concrete*>(first));
+    }
+
+    std::size_t size() const { return shapeCount; }
+
+    // Calls fn(const Shape&) for every shape in the pool, in insertion order
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (const Block& block : blocks) {
+            for (std::size_t i = 0; i < block.count; ++i) {
+                fn(*block.view(block.first + i * block.stride));
+            }
+        }
+    }
+};
+
+// Value shared between clones until one of them writes to it; readers only ever get a const view
+template <typename T>
+class CopyOnWrite {
+private:
+    std::shared_ptr<T> value;
+
+public:
+    explicit CopyOnWrite(T initial) : value(std::make_shared<T>(std::move(initial))) {}
+
+    const T& get() const { return *value; }
+
+    // Writes in place when no clone shares the value; otherwise detaches this handle onto a new value and leaves
+    // the clones with the old one. Like any non-const call, it must not race with copies of this same handle.
+    void set(T newValue) {
+        if (value.use_count() == 1) {
+            *value = std::move(newValue);
+        } else {
+            value = std::make_shared<T>(std::move(newValue));
+        }
+    }
+
+    bool sharesWith(const CopyOnWrite& other) const { return value == other.value; }
+};
+
+// ConcretePrototype: Circle
+class Circle : public Shape {
+private:
+    int radius;
+    std::string color;
+
+public:
+    Circle(int r, const std::string& c) : radius(r), color(c) {}
+
+    // Implement the clone method
+    std::unique_ptr<Shape> clone() const override {
+        return std::make_unique<Circle>(*this);  // Copy itself
+    }
+
+    void cloneN(std::size_t n, ShapePool& out) const override {
+        out.appendCopies(*this, n);
+    }
+
+    // Method to draw the shape (just for demonstration)
+    void draw() const override {
+        static CallSite site("Circle::draw");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Drawing a ", color, " circle with radius ", radius);
+    }
+
+    // Method to set a new color (after cloning)
+    void setColor(const std::string& newColor) {
+        color = newColor;
+    }
+};
+
+// ConcretePrototype: Square
+class Square : public Shape {
+private:
+    int side;
+    std::string color;
+
+public:
+    Square(int s, const std::string& c) : side(s), color(c) {}
+
+    // Implement the clone method
+    std::unique_ptr<Shape> clone() const override {
+        return std::make_unique<Square>(*this);  // Copy itself
+    }
+
+    void cloneN(std::size_t n, ShapePool& out) const override {
+        out.appendCopies(*this, n);
+    }
+
+    // Method to draw the shape
+    void draw() const override {
+        static CallSite site("Square::draw");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Drawing a ", color, " square with side ", side);
+    }
+
+    // Method to set a new color (after cloning)
+    void setColor(const std::string& newColor) {
+        color = newColor;
+    }
+};
+
+// Copy-on-write ConcretePrototype: Circle whose color is shared with its clones
+class CowCircle : public Shape {
+private:
+    int radius;
+    CopyOnWrite<std::string> color;
+
+public:
+    CowCircle(int r, const std::string& c) : radius(r), color(c) {}
+
+    std::unique_ptr<Shape> clone() const override {
+        return std::make_unique<CowCircle>(*this);  // Shares the color, no string copy
+    }
+
+    void cloneN(std::size_t n, ShapePool& out) const override {
+        out.appendCopies(*this, n);
+    }
+
+    void draw() const override {
+        static CallSite site("CowCircle::draw");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Drawing a ", color.get(), " circle with radius ", radius);
+    }
+
+    void setColor(const std::string& newColor) {
+        color.set(newColor);
+    }
+
+    bool sharesColorWith(const CowCircle& other) const {
+        return color.sharesWith(other.color);
+    }
+};
+
+// Copy-on-write ConcretePrototype: Square whose color is shared with its clones
+class CowSquare : public Shape {
+private:
+    int side;
+    CopyOnWrite<std::string> color;
+
+public:
+    CowSquare(int s, const std::string& c) : side(s), color(c) {}
+
+    std::unique_ptr<Shape> clone() const override {
+        return std::make_unique<CowSquare>(*this);  // Shares the color, no string copy
+    }
+
+    void cloneN(std::size_t n, ShapePool& out) const override {
+        out.appendCopies(*this, n);
+    }
+
+    void draw() const override {
+        static CallSite site("CowSquare::draw");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Drawing a ", color.get(), " square with side ", side);
+    }
+
+    void setColor(const std::string& newColor) {
+        color.set(newColor);
+    }
+};
+
+using ColorId = std::uint16_t;
+
+// String pool: every distinct color name is stored once and referred to by a small integer id
+class ColorPool {
+private:
+    std::deque<std::string> names;  // Deque keeps references stable while the pool grows
+    std::unordered_map<std::string_view, ColorId> ids;
+
+public:
+    ColorPool() = default;
+    ColorPool(const ColorPool&) = delete;
+    ColorPool& operator=(const ColorPool&) = delete;
+
+    // Returns the id of name, adding it to the pool the first time it is seen
+    ColorId intern(std::string_view name) {
+        auto found = ids.find(name);
+        if (found != ids.end()) {
+            return found->second;
+        }
+        if (names.size() > UINT16_MAX) {
+            throw std::length_error("ColorPool: too many distinct colors");
+        }
+        auto id = static_cast<ColorId>(names.size());
+        const std::string& stored = names.emplace_back(name);
+        ids.emplace(stored, id);
+        return id;
+    }
+
+    const std::string& name(ColorId id) const { return names[id]; }
+
+    std::size_t size() const { return names.size(); }
+};
+
+// ConcretePrototype: Circle with an interned color (trivially copyable, cloning never allocates a string)
+class CompactCircle : public Shape {
+private:
+    int radius;
+    ColorId color;
+    const ColorPool* palette;
+
+public:
+    CompactCircle(int r, ColorId c, const ColorPool& pool) : radius(r), color(c), palette(&pool) {}
+
+    std::unique_ptr<Shape> clone() const override {
+        return std::make_unique<CompactCircle>(*this);
+    }
+
+    void cloneN(std::size_t n, ShapePool& out) const override {
+        out.appendCopies(*this, n);
+    }
+
+    void draw() const override {
+        static CallSite site("CompactCircle::draw");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Drawing a ", palette->name(color), " circle with radius ", radius);
+    }
+
+    void setColor(ColorId newColor) {
+        color = newColor;
+    }
+};
+
+// ConcretePrototype: Square with an interned color
+class CompactSquare : public Shape {
+private:
+    int side;
+    ColorId color;
+    const ColorPool* palette;
+
+public:
+    CompactSquare(int s, ColorId c, const ColorPool& pool) : side(s), color(c), palette(&pool) {}
+
+    std::unique_ptr<Shape> clone() const override {
+        return std::make_unique<CompactSquare>(*this);
+    }
+
+    void cloneN(std::size_t n, ShapePool& out) const override {
+        out.appendCopies(*this, n);
+    }
+
+    void draw() const override {
+        static CallSite site("CompactSquare::draw");
+        ScopedCall call(site);
+        logEvent<LogLevel::Info>("Drawing a ", palette->name(color), " square with side ", side);
+    }
+
+    void setColor(ColorId newColor) {
+        color = newColor;
+    }
+};
+
+using PrototypeId = std::uint32_t;
+
+// Registry of prototypes: clients clone by id and get the concrete type back without RTTI
+class PrototypeRegistry {
+private:
+    using TypeKey = const void*;
+
+    struct Entry {
+        std::unique_ptr<Shape> prototype;
+        TypeKey type;
+    };
+
+    // One distinct address per concrete type, used instead of typeid/dynamic_cast
+    template <typename T>
+    static TypeKey typeKeyOf() {
+        static const char key = 0;
+        return &key;
+    }
+
+    ColorPool palette;
+    std::vector<Entry> entries;
+
+    template <typename T>
+    const T& prototypeAs(PrototypeId id) const {
+        const Entry& entry = entries.at(id);
+        if (entry.type != typeKeyOf<T>()) {
+            throw std::invalid_argument("PrototypeRegistry: prototype has a different type");
+        }
+        return static_cast<const T&>(*entry.prototype);
+    }
+
+public:
+    // Shared color pool for every prototype in this registry
+    ColorPool& colors() { return palette; }
+    const ColorPool& colors() const { return palette; }
+
+    // Stores a prototype and returns the id to clone it by
+    template <typename T>
+    PrototypeId add(T prototype) {
+        static_assert(std::is_base_of_v<Shape, T>, "Prototypes must derive from Shape");
+        entries.push_back(Entry{std::make_unique<T>(std::move(prototype)), typeKeyOf<T>()});
+        return static_cast<PrototypeId>(entries.size() - 1);
+    }
+
+    // Generic clone through the Shape interface
+    std::unique_ptr<Shape> clone(PrototypeId id) const {
+        return entries.at(id).prototype->clone();
+    }
+
+    // Typed clone on the heap, ready to customize (throws std::invalid_argument if T is not the stored type)
+    template <typename T>
+    std::unique_ptr<T> cloneAs(PrototypeId id) const {
+        return std::make_unique<T>(prototypeAs<T>(id));
+    }
+
+    // Typed clone by value, no heap allocation at all for the compact shapes
+    template <typename T>
+    T copyAs(PrototypeId id) const {
+        return prototypeAs<T>(id);
+    }
+
+    std::size_t size() const { return entries.size(); }
+};
@@ -11,40 +11,136 @@ Explanation:
 - Private Constructor: The constructor is private to prevent creating objects from outside the class.
 - static Singleton* getInstance(): A static method that checks if the instance exists. If it doesn't, it creates one. If it does, it returns the existing instance.
 - Copy Prevention: The copy constructor and assignment operator are deleted to prevent copying the Singleton instance.
+
+Thread Safety:
+The classic getInstance() above is NOT thread-safe: two threads can both see instance == nullptr and build two instances.
+Putting a mutex around every call fixes that, but then every caller pays for a lock even though the instance is only
+created once. Two concurrent variants are provided as templates (Singleton<T> style, named after their technique):
+- MeyersSingleton<T>: A function-local static. Since C++11 the compiler guarantees its initialization runs exactly once,
+  and every later call is a single load of the guard byte.
+- AtomicSingleton<T>: Double-checked locking on a std::atomic<T*>. The fast path is one acquire load; the mutex is only
+  taken while the instance does not exist yet. The release store publishes the fully constructed object.
+- MutexSingleton<T>: The naive lock-on-every-call version, kept only as the benchmark baseline.
+T befriends the template (or has a public constructor) so the template can construct it. Each variant owns its own
+instance, so MeyersSingleton<Config> and AtomicSingleton<Config> are two different Configs.
+
+Contention:
+A correct singleton is still a hotspot when it holds mutable state (counters, logging) and every core writes to it:
+the cache line holding that state bounces between cores on every write. Two variants split the state instead:
+- ThreadLocalSingleton<T>: One instance per thread, so writes never leave the core. Instances are kept alive in a
+  registry after their thread exits, and aggregate() folds over all of them for reads.
+- ShardedSingleton<T, N>: N instances, each padded to its own cache line (64 bytes).
+  Threads are spread over the shards round-robin; aggregate() folds over all shards for reads.
+Because aggregate() reads while other threads write, T's mutable state should be atomic (relaxed is enough).
 */
+#include "singleton.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <iostream>
+#include <thread>
+
+// Runs getInstance() from several threads at once and returns the average ns per call
+template <typename SingletonType>
+double benchmarkGetInstance(unsigned threadCount, std::uint64_t callsPerThread) {
+    std::atomic<bool> start{false};
+    std::atomic<std::uintptr_t> sink{0};
+    std::vector<std::thread> workers;
+
+    for (unsigned t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&]() {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            std::uintptr_t local = 0;
+            for (std::uint64_t i = 0; i < callsPerThread; ++i) {
+                local ^= reinterpret_cast<std::uintptr_t>(SingletonType::getInstance());
+            }
+            sink.fetch_xor(local, std::memory_order_relaxed);
+        });
+    }
 
-class Singleton {
-private:
-    // Private static instance of the class (single instance)
-    static Singleton* instance;
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // Wall time spent per call as seen by one thread (all threads run in parallel)
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+    return ns / static_cast<double>(callsPerThread);
+}
 
-    // Private constructor to prevent instantiation
-    Singleton() {
-        std::cout << "Singleton instance created.\n";
+void runConcurrentBenchmark() {
+    const std::uint64_t callsPerThread = 2'000'000;
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "\nPer-call latency of getInstance() (ns/call per thread):\n";
+    std::cout << "threads\tmeyers\tatomic\tmutex\n";
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        double meyers = benchmarkGetInstance<MeyersSingleton<Config>>(threads, callsPerThread);
+        double atomic = benchmarkGetInstance<AtomicSingleton<Config>>(threads, callsPerThread);
+        double locked = benchmarkGetInstance<MutexSingleton<Config>>(threads, callsPerThread);
+        std::cout << threads << '\t' << meyers << '\t' << atomic << '\t' << locked << '\n';
     }
+}
+
+std::uint64_t sumHits(std::uint64_t total, const HitCounter& counter) {
+    return total + counter.value();
+}
+
+// Runs record() on the counter returned by getCounter() from several threads, returns million ops per second
+template <typename GetCounter>
+double benchmarkHitCounter(unsigned threadCount, std::uint64_t opsPerThread, GetCounter getCounter) {
+    std::atomic<bool> start{false};
+    std::vector<std::thread> workers;
 
-public:
-    // Public static method to provide access to the instance
-    static Singleton* getInstance() {
-        if (instance == nullptr) {
-            instance = new Singleton();
-        }
-        return instance;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&]() {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (std::uint64_t i = 0; i < opsPerThread; ++i) {
+                getCounter()->record();
+            }
+        });
     }
 
-    // Example method to demonstrate functionality
-    void showMessage() {
-        std::cout << "Hello from the Singleton instance!\n";
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
     }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    return static_cast<double>(threadCount * opsPerThread) / seconds / 1e6;
+}
+
+void runContentionBenchmark() {
+    using GlobalCounter = AtomicSingleton<HitCounter>;
+    using LocalCounter = ThreadLocalSingleton<HitCounter>;
+    using ShardedCounter = ShardedSingleton<HitCounter, 64>;
+
+    const std::uint64_t opsPerThread = 2'000'000;
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
 
-    // Delete copy constructor and assignment operator to prevent copying
-    Singleton(const Singleton&) = delete;
-    Singleton& operator=(const Singleton&) = delete;
-};
+    std::cout << "\nThroughput of record() on a shared counter (Mops/s):\n";
+    std::cout << "threads\tglobal\tthread_local\tsharded\n";
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        double global = benchmarkHitCounter(threads, opsPerThread, [] { return GlobalCounter::getInstance(); });
+        double local = benchmarkHitCounter(threads, opsPerThread, [] { return LocalCounter::getInstance(); });
+        double sharded = benchmarkHitCounter(threads, opsPerThread, [] { return ShardedCounter::getInstance(); });
+        std::cout << threads << '\t' << global << '\t' << local << "\t\t" << sharded << '\n';
+    }
 
-// Initialize the static instance pointer to nullptr
-Singleton* Singleton::instance = nullptr;
+    // Reads merge all copies, so every variant reports the same total
+    std::cout << "Total hits: global=" << GlobalCounter::getInstance()->value()
+              << " thread_local=" << LocalCounter::aggregate<std::uint64_t>(0, sumHits)
+              << " sharded=" << ShardedCounter::aggregate<std::uint64_t>(0, sumHits) << '\n';
+}
 
 int main() {
     // Get the single instance of the Singleton class
@@ -57,8 +153,31 @@ int main() {
 
     // Both pointers point to the same instance
     if (singleton1 == singleton2) {
-        std::cout << "Both variables point to the same Singleton instance.\n";
+        logEvent<LogLevel::Info>("Both variables point to the same Singleton instance.");
+    }
+
+    // Each concurrent variant keeps its own Config, so "Config instance created." is logged once per variant. Within
+    // one variant, threads racing on the first call all get the same instance.
+    std::array<Config*, 4> seen{};
+    logEvent<LogLevel::Info>("AtomicSingleton<Config>, ", seen.size(), " threads racing on the first call:");
+    std::vector<std::thread> racers;
+    for (std::size_t i = 0; i < seen.size(); ++i) {
+        racers.emplace_back([&seen, i] { seen[i] = AtomicSingleton<Config>::getInstance(); });
+    }
+    for (std::thread& racer : racers) {
+        racer.join();
     }
+    bool shared = std::all_of(seen.begin(), seen.end(), [&seen](const Config* config) { return config == seen[0]; });
+    logEvent<LogLevel::Info>(shared ? "All of them got the same instance." : "The threads got different instances!");
+    seen[0]->showMessage();
+    logEvent<LogLevel::Info>("MeyersSingleton<Config>:");
+    MeyersSingleton<Config>::getInstance()->showMessage();
+    logEvent<LogLevel::Info>("MutexSingleton<Config>:");
+    MutexSingleton<Config>::getInstance()->showMessage();
+    flushEvents();  // The benchmarks print to std::cout directly
+
+    runConcurrentBenchmark();
+    runContentionBenchmark();
 
     return 0;
 }
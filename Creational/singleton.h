@@ -0,0 +1,217 @@
+// Singleton pattern classes. singleton.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include "instrumentation.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Singleton {
+private:
+    // Private static instance of the class (single instance)
+    static Singleton* instance;
+
+    // Private constructor to prevent instantiation
+    Singleton() {
+        logEvent<LogLevel::Info>("Singleton instance created.");
+    }
+
+public:
+    // Public static method to provide access to the instance
+    static Singleton* getInstance() {
+        if (instance == nullptr) {
+            instance = new Singleton();
+        }
+        return instance;
+    }
+
+    // Example method to demonstrate functionality
+    void showMessage() {
+        logEvent<LogLevel::Info>("Hello from the Singleton instance!");
+    }
+
+    // Delete copy constructor and assignment operator to prevent copying
+    Singleton(const Singleton&) = delete;
+    Singleton& operator=(const Singleton&) = delete;
+};
+
+// Initialize the static instance pointer to nullptr
+inline Singleton* Singleton::instance = nullptr;
+
+// Concurrent variant 1: Meyers singleton (function-local static, initialized once by the compiler)
+template <typename T>
+class MeyersSingleton {
+public:
+    static T* getInstance() {
+        static T instance;
+        return &instance;
+    }
+
+    MeyersSingleton() = delete;
+};
+
+// Concurrent variant 2: double-checked locking with acquire/release atomics
+template <typename T>
+class AtomicSingleton {
+private:
+    static inline std::atomic<T*> instance{nullptr};
+    static inline std::mutex creationMutex;
+
+public:
+    static T* getInstance() {
+        // Fast path: a single uncontended acquire load once the instance exists
+        T* current = instance.load(std::memory_order_acquire);
+        if (current == nullptr) {
+            std::lock_guard<std::mutex> lock(creationMutex);
+            current = instance.load(std::memory_order_relaxed);
+            if (current == nullptr) {
+                current = new T();
+                instance.store(current, std::memory_order_release);
+            }
+        }
+        return current;
+    }
+
+    AtomicSingleton() = delete;
+};
+
+// Baseline: every call takes the lock (correct, but serializes all callers)
+template <typename T>
+class MutexSingleton {
+private:
+    static inline T* instance = nullptr;
+    static inline std::mutex creationMutex;
+
+public:
+    static T* getInstance() {
+        std::lock_guard<std::mutex> lock(creationMutex);
+        if (instance == nullptr) {
+            instance = new T();
+        }
+        return instance;
+    }
+
+    MutexSingleton() = delete;
+};
+
+// Example type managed by the concurrent singletons
+class Config {
+private:
+    Config() {
+        logEvent<LogLevel::Info>("Config instance created.");
+    }
+
+    friend class MeyersSingleton<Config>;
+    friend class AtomicSingleton<Config>;
+    friend class MutexSingleton<Config>;
+
+public:
+    void showMessage() const {
+        logEvent<LogLevel::Info>("Hello from the Config instance!");
+    }
+
+    Config(const Config&) = delete;
+    Config& operator=(const Config&) = delete;
+};
+
+// Wraps a value so that no other value shares its cache line
+template <typename T>
+struct alignas(kCacheLineSize) CacheLinePadded {
+    T value;
+};
+
+// Per-thread variant: each thread gets its own instance, reads aggregate over all of them
+template <typename T>
+class ThreadLocalSingleton {
+private:
+    static inline std::mutex registryMutex;
+    static inline std::vector<std::unique_ptr<CacheLinePadded<T>>> registry;
+
+    // Called once per thread; the registry owns the instance so it outlives the thread
+    static T* createForThisThread() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(std::make_unique<CacheLinePadded<T>>());
+        return &registry.back()->value;
+    }
+
+public:
+    static T* getInstance() {
+        thread_local T* instance = createForThisThread();
+        return instance;
+    }
+
+    // Folds every thread's instance into a single result: fold(accumulator, const T&) -> accumulator
+    template <typename Result, typename Fold>
+    static Result aggregate(Result init, Fold fold) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& padded : registry) {
+            init = fold(std::move(init), padded->value);
+        }
+        return init;
+    }
+
+    ThreadLocalSingleton() = delete;
+};
+
+// Sharded variant: N cache-line padded instances, each thread sticks to one shard
+template <typename T, std::size_t N>
+class ShardedSingleton {
+    static_assert(N > 0, "ShardedSingleton needs at least one shard");
+
+private:
+    static inline CacheLinePadded<T> shards[N];
+    static inline std::atomic<std::size_t> nextShard{0};
+
+    static std::size_t shardIndex() {
+        thread_local std::size_t index = nextShard.fetch_add(1, std::memory_order_relaxed) % N;
+        return index;
+    }
+
+public:
+    static T* getInstance() {
+        return &shards[shardIndex()].value;
+    }
+
+    static T* getShard(std::size_t index) {
+        return &shards[index % N].value;
+    }
+
+    static constexpr std::size_t shardCount() {
+        return N;
+    }
+
+    // Folds every shard into a single result: fold(accumulator, const T&) -> accumulator
+    template <typename Result, typename Fold>
+    static Result aggregate(Result init, Fold fold) {
+        for (const auto& padded : shards) {
+            init = fold(std::move(init), padded.value);
+        }
+        return init;
+    }
+
+    ShardedSingleton() = delete;
+};
+
+// Example of singleton state that every thread writes to
+class HitCounter {
+private:
+    std::atomic<std::uint64_t> hits{0};
+
+public:
+    // Public constructor: the per-thread and sharded singletons need to create several instances
+    HitCounter() = default;
+
+    void record() {
+        hits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const {
+        return hits.load(std::memory_order_relaxed);
+    }
+
+    HitCounter(const HitCounter&) = delete;
+    HitCounter& operator=(const HitCounter&) = delete;
+};
@@ -0,0 +1,12 @@
+// Heap counters behind the allocation figures of the example programs and pattern_bench. Linking
+// patterns::counting_allocator replaces the global operator new with one that counts every call and its bytes,
+// and also feeds countAllocation() for the call-site metrics.
+#pragma once
+
+#include <cstddef>
+
+// Calls to the global operator new so far, across all threads
+std::size_t heapAllocationCount();
+
+// Bytes requested from the global operator new so far, across all threads
+std::size_t heapAllocatedBytes();
@@ -0,0 +1,786 @@
+// Instrumentation shared by all pattern classes. It reports their hot-path events without synchronous std::cout
+// writes.
+//
+// Event log:
+// - logEvent<Level>(args...) formats its arguments straight into a fixed-size LogRecord. The record goes into a
+//   ring buffer owned by the calling thread: one producer, no locks. A full ring drops the record and counts it,
+//   so the caller never blocks.
+// - A background thread drains every ring into an EventSink, ordered by timestamp: every 0.5 ms while events
+//   arrive, backing off to 8 ms when idle.
+//   The default sink prints the message lines to std::cout. setSink() installs any other sink.
+// - Levels below PATTERNS_LOG_LEVEL are removed at compile time, call and formatting included
+//   (0 trace, 1 debug, 2 info, 3 warn, 4 error, 5 off).
+// - eventStream() is the calling thread's std::ostream that turns each line written to it into an Info record.
+//   Classes that take an output stream use it as their default instead of std::cout, and write through
+//   localStream() so that the default is safe on any thread.
+//
+// Call-site metrics:
+// - A CallSite is a named counter block, usually a function-local static. Add a ScopedCall to the function to
+//   record one call (every call of a virtual method is one dispatch), the time spent in nanoseconds in a
+//   power-of-two latency histogram, and the heap allocations made on the calling thread. A call that handles a
+//   whole batch passes the batch size to ScopedCall, so the site also counts the items processed.
+// - Per-thread counters. A thread only ever writes its own counters, so instrumented code running on many threads
+//   does not share cache lines. Readers sum the threads' counters.
+// - Heap allocations are counted only in programs whose replacement operator new calls countAllocation().
+// - writePrometheus() and writeJson() export every call site, plus the event log's record and drop counts.
+// - With PATTERNS_METRICS=0, CallSite and ScopedCall compile to nothing.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifndef PATTERNS_LOG_LEVEL
+#define PATTERNS_LOG_LEVEL 2
+#endif
+
+#ifndef PATTERNS_METRICS
+#define PATTERNS_METRICS 1
+#endif
+
+// Fixed rather than std::hardware_destructive_interference_size: that value can change with -mtune, and a
+// header shared by several targets must give every one of them the same layout
+inline constexpr std::size_t kCacheLineSize = 64;
+
+enum class LogLevel : std::uint8_t { Trace, Debug, Info, Warn, Error, Off };
+
+inline constexpr LogLevel kCompiledLogLevel = static_cast<LogLevel>(PATTERNS_LOG_LEVEL);
+inline constexpr bool kMetricsEnabled = PATTERNS_METRICS != 0;
+
+template <LogLevel Level>
+inline constexpr bool logEnabled = Level != LogLevel::Off && Level >= kCompiledLogLevel;
+
+constexpr std::string_view logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "trace";
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info: return "info";
+        case LogLevel::Warn: return "warn";
+        case LogLevel::Error: return "error";
+        case LogLevel::Off: break;
+    }
+    return "off";
+}
+
+// One formatted event, sized to four cache lines; longer messages are cut and marked as truncated
+struct LogRecord {
+    static constexpr std::size_t kTextBytes = 4 * kCacheLineSize - 16;
+
+    std::int64_t timestampNs = 0;  // steady_clock
+    std::uint32_t thread = 0;      // Sequential id of the thread that logged it
+    std::uint16_t length = 0;
+    LogLevel level = LogLevel::Info;
+    bool truncated = false;
+    char text[kTextBytes];
+
+    std::string_view message() const { return std::string_view(text, length); }
+
+    void append(std::string_view part) {
+        std::size_t room = kTextBytes - length;
+        if (part.size() > room) {
+            part = part.substr(0, room);
+            truncated = true;
+        }
+        std::copy(part.begin(), part.end(), text + length);
+        length = static_cast<std::uint16_t>(length + part.size());
+    }
+
+    void append(char value) { append(std::string_view(&value, 1)); }
+    void append(const char* value) { append(std::string_view(value)); }
+    void append(const std::string& value) { append(std::string_view(value)); }
+    void append(bool value) { append(std::string_view(value ? "true" : "false")); }
+
+    template <typename T>
+        requires(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+    void append(T value) {
+        char digits[32];
+        auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+        if (error == std::errc()) {
+            append(std::string_view(digits, static_cast<std::size_t>(end - digits)));
+        }
+    }
+};
+
+static_assert(sizeof(LogRecord) == 4 * kCacheLineSize);
+
+// Where drained records go. write() is only ever called from one thread at a time.
+class EventSink {
+public:
+    virtual void write(const LogRecord& record) = 0;
+    virtual void flush() {}
+    virtual ~EventSink() = default;
+};
+
+// Writes each message as a line, the way the classes used to print it
+class OstreamEventSink : public EventSink {
+private:
+    std::ostream& output;
+
+public:
+    explicit OstreamEventSink(std::ostream& out) : output(out) {}
+
+    void write(const LogRecord& record) override {
+        output << record.message() << (record.truncated ? "...\n" : "\n");
+    }
+
+    void flush() override {
+        output.flush();
+    }
+};
+
+// Drops everything, for benchmarks that only want the producer-side cost
+class DiscardEventSink : public EventSink {
+public:
+    void write(const LogRecord&) override {}
+};
+
+// Single-producer ring of records owned by one thread. The drain thread is its only consumer.
+class EventRing {
+private:
+    std::unique_ptr<LogRecord[]> slots;
+    std::size_t mask;
+    std::uint32_t threadId;
+    alignas(kCacheLineSize) std::atomic<std::size_t> head{0};  // Next slot the producer fills
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail{0};  // Next slot the consumer reads
+    std::atomic<std::uint64_t> dropped{0};
+    std::atomic<bool> retired{false};  // The owning thread has exited
+
+public:
+    EventRing(std::size_t capacity, std::uint32_t thread)
+        : slots(std::make_unique<LogRecord[]>(std::bit_ceil(capacity))), mask(std::bit_ceil(capacity) - 1),
+          threadId(thread) {}
+
+    // Slot for the next record, or nullptr (and one more drop) when the consumer has not caught up
+    LogRecord* beginWrite(LogLevel level) {
+        std::size_t position = head.load(std::memory_order_relaxed);
+        if (position - tail.load(std::memory_order_acquire) > mask) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        LogRecord& record = slots[position & mask];
+        record.timestampNs = std::chrono::steady_clock::now().time_since_epoch().count();
+        record.thread = threadId;
+        record.level = level;
+        record.length = 0;
+        record.truncated = false;
+        return &record;
+    }
+
+    void endWrite() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Records published so far; valid until release()
+    std::size_t readable(std::size_t& first) const {
+        first = tail.load(std::memory_order_relaxed);
+        return head.load(std::memory_order_acquire) - first;
+    }
+
+    const LogRecord& at(std::size_t position) const { return slots[position & mask]; }
+
+    void release(std::size_t count) {
+        tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    std::uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    std::uint64_t writtenCount() const { return head.load(std::memory_order_relaxed); }
+
+    void retire() { retired.store(true, std::memory_order_release); }
+    bool isRetired() const { return retired.load(std::memory_order_acquire); }
+};
+
+// Process-wide event log: hands out the per-thread rings and runs the drain thread
+class EventLog {
+private:
+    static constexpr std::size_t kRingCapacity = 1024;
+    static constexpr std::chrono::microseconds kBusyInterval{500};
+    static constexpr std::chrono::microseconds kIdleInterval{8000};  // Backs off while nothing is logged
+
+    // Keeps the calling thread's ring; the drain thread frees it once it is empty after the thread exits
+    struct RingHandle {
+        std::shared_ptr<EventRing> ring;
+        ~RingHandle() {
+            if (ring) {
+                ring->retire();
+            }
+        }
+    };
+
+    std::mutex registryMutex;  // Guards rings and threadCount
+    std::vector<std::shared_ptr<EventRing>> rings;
+    std::uint32_t threadCount = 0;
+    std::uint64_t retiredWritten = 0;
+    std::uint64_t retiredDropped = 0;
+
+    std::mutex drainMutex;  // One consumer at a time: the drain thread or flush()
+    std::shared_ptr<EventSink> sink = std::make_shared<OstreamEventSink>(std::cout);
+    std::vector<const LogRecord*> batch;  // Reused across drains
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread drainer;
+
+    EventLog() : drainer([this] { drainLoop(); }) {}
+
+    EventRing& localRing() {
+        thread_local RingHandle handle;
+        if (!handle.ring) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            handle.ring = std::make_shared<EventRing>(kRingCapacity, threadCount++);
+            rings.push_back(handle.ring);
+        }
+        return *handle.ring;
+    }
+
+    // Writes everything published so far, oldest first, and returns whether there was anything; the caller holds
+    // drainMutex
+    bool drainLocked() {
+        std::vector<std::shared_ptr<EventRing>> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            snapshot = rings;
+        }
+
+        batch.clear();
+        std::vector<std::size_t> counts(snapshot.size());
+        for (std::size_t i = 0; i < snapshot.size(); ++i) {
+            std::size_t first = 0;
+            counts[i] = snapshot[i]->readable(first);
+            for (std::size_t n = 0; n < counts[i]; ++n) {
+                batch.push_back(&snapshot[i]->at(first + n));
+            }
+        }
+        if (batch.empty()) {
+            pruneRetired();
+            return false;
+        }
+
+        std::stable_sort(batch.begin(), batch.end(), [](const LogRecord* lhs, const LogRecord* rhs) {
+            return lhs->timestampNs < rhs->timestampNs;
+        });
+        for (const LogRecord* record : batch) {
+            sink->write(*record);
+        }
+        sink->flush();
+        for (std::size_t i = 0; i < snapshot.size(); ++i) {
+            snapshot[i]->release(counts[i]);
+        }
+        pruneRetired();
+        return true;
+    }
+
+    // Forgets the rings of exited threads once they are empty, keeping their totals
+    void pruneRetired() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto done = std::remove_if(rings.begin(), rings.end(), [this](const std::shared_ptr<EventRing>& ring) {
+            std::size_t first = 0;
+            if (!ring->isRetired() || ring->readable(first) != 0) {
+                return false;
+            }
+            retiredWritten += ring->writtenCount();
+            retiredDropped += ring->droppedCount();
+            return true;
+        });
+        rings.erase(done, rings.end());
+    }
+
+    void drainLoop() {
+        std::chrono::microseconds interval = kBusyInterval;
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        while (!stopping) {
+            wake.wait_for(lock, interval);
+            lock.unlock();
+            bool busy = false;
+            {
+                std::lock_guard<std::mutex> drainLock(drainMutex);
+                busy = drainLocked();
+            }
+            interval = busy ? kBusyInterval : std::min(interval * 2, kIdleInterval);
+            lock.lock();
+        }
+    }
+
+public:
+    static EventLog& instance() {
+        static EventLog log;
+        return log;
+    }
+
+    // Formats args into the calling thread's ring; see logEvent() for the compile-time level check
+    template <typename... Args>
+    void write(LogLevel level, const Args&... args) {
+        EventRing& ring = localRing();
+        if (LogRecord* record = ring.beginWrite(level)) {
+            (record->append(args), ...);
+            ring.endWrite();
+        }
+    }
+
+    // Sets up the calling thread's ring now instead of on its first event
+    void attachThread() {
+        localRing();
+    }
+
+    // Drains pending records to the current sink before switching; returns the previous sink
+    std::shared_ptr<EventSink> setSink(std::shared_ptr<EventSink> newSink) {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        drainLocked();
+        std::swap(sink, newSink);
+        return newSink;
+    }
+
+    // Writes every record published so far before returning, e.g. before printing to std::cout directly
+    void flush() {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        drainLocked();
+    }
+
+    // Records accepted and records dropped because a ring was full, over all threads so far
+    std::uint64_t writtenCount() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        std::uint64_t total = retiredWritten;
+        for (const auto& ring : rings) {
+            total += ring->writtenCount();
+        }
+        return total;
+    }
+
+    std::uint64_t droppedCount() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        std::uint64_t total = retiredDropped;
+        for (const auto& ring : rings) {
+            total += ring->droppedCount();
+        }
+        return total;
+    }
+
+    ~EventLog() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        drainer.join();
+        std::lock_guard<std::mutex> lock(drainMutex);
+        drainLocked();
+    }
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+};
+
+// Logs one event made of args (strings, characters and numbers). Removed entirely below PATTERNS_LOG_LEVEL.
+template <LogLevel Level, typename... Args>
+void logEvent(const Args&... args) {
+    if constexpr (logEnabled<Level>) {
+        EventLog::instance().write(Level, args...);
+    }
+}
+
+inline void flushEvents() {
+    EventLog::instance().flush();
+}
+
+// Stream buffer behind eventStream(). The pending line is per thread, so the threads' streams can share one buffer.
+class EventStreamBuf : public std::streambuf {
+private:
+    // One byte more than a record holds, so that a cut line also arrives as a truncated record
+    struct PendingLine {
+        std::array<char, LogRecord::kTextBytes + 1> text;
+        std::size_t length = 0;
+    };
+
+    static PendingLine& pending() {
+        thread_local PendingLine line;
+        return line;
+    }
+
+    static void add(PendingLine& line, const char* data, std::size_t count) {
+        count = std::min(count, line.text.size() - line.length);
+        std::copy(data, data + count, line.text.data() + line.length);
+        line.length += count;
+    }
+
+    static void emit(PendingLine& line) {
+        EventLog::instance().write(LogLevel::Info, std::string_view(line.text.data(), line.length));
+        line.length = 0;
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+        char c = traits_type::to_char_type(ch);
+        PendingLine& line = pending();
+        if (c == '\n') {
+            emit(line);
+        } else {
+            add(line, &c, 1);
+        }
+        return ch;
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        PendingLine& line = pending();
+        std::string_view rest(data, static_cast<std::size_t>(count));
+        for (std::size_t newline = rest.find('\n'); newline != std::string_view::npos; newline = rest.find('\n')) {
+            add(line, rest.data(), newline);
+            emit(line);
+            rest.remove_prefix(newline + 1);
+        }
+        add(line, rest.data(), rest.size());
+        return count;
+    }
+};
+
+// The one buffer behind every thread's eventStream()
+inline EventStreamBuf& eventStreamBuffer() {
+    static EventStreamBuf buffer;
+    return buffer;
+}
+
+// Output stream that reports each line as an Info event. Each thread gets its own stream over the shared buffer:
+// every insertion updates the stream's formatting state, so one std::ostream used by several threads is a data race.
+inline std::ostream& eventStream() {
+    struct ThreadStream : std::ostream {
+        ThreadStream() : std::ostream(&eventStreamBuffer()) {
+            if constexpr (!logEnabled<LogLevel::Info>) {
+                setstate(std::ios_base::badbit);  // Fails fast when Info is off
+            }
+        }
+    };
+    thread_local ThreadStream stream;
+    return stream;
+}
+
+// out, or the calling thread's eventStream() if out is another thread's. Classes that keep the stream they were
+// constructed with write through this, since they may be called from threads other than the one that built them.
+inline std::ostream& localStream(std::ostream& out) {
+    return out.rdbuf() == &eventStreamBuffer() ? eventStream() : out;
+}
+
+// --- Call-site metrics ---
+
+// Allocations made by the current thread, for programs whose operator new calls countAllocation()
+inline thread_local std::uint64_t threadAllocations = 0;
+
+inline void countAllocation() {
+    ++threadAllocations;
+}
+
+inline constexpr std::size_t kMaxCallSites = 128;
+inline constexpr std::size_t kLatencyBuckets = 20;  // <= 16 ns, <= 32 ns, ... <= 4.2 ms, then +Inf
+
+// Upper bound of a latency bucket in nanoseconds (the last bucket has none)
+constexpr std::uint64_t latencyBucketBound(std::size_t bucket) {
+    return std::uint64_t{16} << bucket;
+}
+
+constexpr std::size_t latencyBucket(std::uint64_t ns) {
+    std::size_t bucket = ns <= 16 ? 0 : static_cast<std::size_t>(std::bit_width((ns - 1) >> 4));
+    return std::min(bucket, kLatencyBuckets - 1);
+}
+
+static_assert(latencyBucket(16) == 0 && latencyBucket(17) == 1 && latencyBucket(64) == 2 && latencyBucket(65) == 3);
+
+// Counters of one call site on one thread. Only the owning thread writes them, so plain loads and stores suffice.
+struct SiteCounters {
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> items{0};  // Items processed: one per call, or the batch size of a batched call
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> totalNs{0};
+    std::array<std::atomic<std::uint64_t>, kLatencyBuckets> latency{};
+
+    static void add(std::atomic<std::uint64_t>& counter, std::uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+};
+
+// Totals of one call site over all threads
+struct CallSiteStats {
+    std::string name;
+    std::uint64_t calls = 0;
+    std::uint64_t items = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t totalNs = 0;
+    std::array<std::uint64_t, kLatencyBuckets> latency{};
+
+    double meanNs() const { return calls == 0 ? 0.0 : static_cast<double>(totalNs) / static_cast<double>(calls); }
+};
+
+// Names the call sites and owns every thread's counters
+class MetricsRegistry {
+private:
+    using ThreadMetrics = std::array<SiteCounters, kMaxCallSites>;
+
+    // Frees the thread's counters when it exits, after folding them into the retired totals
+    struct ThreadHandle {
+        ThreadMetrics* metrics = nullptr;
+        ~ThreadHandle() {
+            if (metrics) {
+                MetricsRegistry::instance().retire(metrics);
+            }
+        }
+    };
+
+    mutable std::mutex mutex;
+    std::vector<std::string> names;  // Index is the call-site id; the last id collects any sites beyond the limit
+    std::vector<ThreadMetrics*> live;
+    std::array<CallSiteStats, kMaxCallSites> retired;
+
+    static void accumulate(CallSiteStats& into, const SiteCounters& from) {
+        into.calls += from.calls.load(std::memory_order_relaxed);
+        into.items += from.items.load(std::memory_order_relaxed);
+        into.allocations += from.allocations.load(std::memory_order_relaxed);
+        into.totalNs += from.totalNs.load(std::memory_order_relaxed);
+        for (std::size_t bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+            into.latency[bucket] += from.latency[bucket].load(std::memory_order_relaxed);
+        }
+    }
+
+    void retire(ThreadMetrics* metrics) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t id = 0; id < kMaxCallSites; ++id) {
+            accumulate(retired[id], (*metrics)[id]);
+        }
+        live.erase(std::remove(live.begin(), live.end(), metrics), live.end());
+        delete metrics;
+    }
+
+    MetricsRegistry() = default;
+
+public:
+    static MetricsRegistry& instance() {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    // Id for name; sites registered under the same name share their counters
+    std::size_t registerSite(std::string_view name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = std::find(names.begin(), names.end(), name);
+        if (found != names.end()) {
+            return static_cast<std::size_t>(found - names.begin());
+        }
+        if (names.size() == kMaxCallSites - 1) {
+            names.emplace_back("(other call sites)");
+        }
+        if (names.size() == kMaxCallSites) {
+            return kMaxCallSites - 1;
+        }
+        names.emplace_back(name);
+        return names.size() - 1;
+    }
+
+    // The calling thread's counters for site id, allocated on the thread's first call
+    SiteCounters& local(std::size_t id) {
+        thread_local ThreadHandle handle;
+        if (!handle.metrics) {
+            auto* metrics = new ThreadMetrics();
+            std::lock_guard<std::mutex> lock(mutex);
+            live.push_back(metrics);
+            handle.metrics = metrics;
+        }
+        return (*handle.metrics)[id];
+    }
+
+    // Totals per call site, summed over live and exited threads
+    std::vector<CallSiteStats> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<CallSiteStats> sites(names.size());
+        for (std::size_t id = 0; id < names.size(); ++id) {
+            sites[id] = retired[id];
+            sites[id].name = names[id];
+            for (const ThreadMetrics* metrics : live) {
+                accumulate(sites[id], (*metrics)[id]);
+            }
+        }
+        return sites;
+    }
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+};
+
+// A named place in the code whose calls are counted, typically `static CallSite site("Class::method");`
+class CallSite {
+private:
+    std::size_t id = 0;
+
+public:
+    explicit CallSite(std::string_view name) {
+        if constexpr (kMetricsEnabled) {
+            id = MetricsRegistry::instance().registerSite(name);
+        }
+    }
+
+    // The calling thread's counters for this site
+    SiteCounters& localCounters() const {
+        return MetricsRegistry::instance().local(id);
+    }
+
+    void record(std::uint64_t ns, std::uint64_t allocations, std::uint64_t items = 1) const {
+        if constexpr (kMetricsEnabled) {
+            record(localCounters(), ns, allocations, items);
+        }
+    }
+
+    static void record(SiteCounters& counters, std::uint64_t ns, std::uint64_t allocations, std::uint64_t items = 1) {
+        if constexpr (kMetricsEnabled) {
+            SiteCounters::add(counters.calls, 1);
+            SiteCounters::add(counters.items, items);
+            SiteCounters::add(counters.allocations, allocations);
+            SiteCounters::add(counters.totalNs, ns);
+            SiteCounters::add(counters.latency[latencyBucket(ns)], 1);
+        }
+    }
+};
+
+// Records one call of site when it goes out of scope: time spent and allocations made on this thread
+class ScopedCall {
+private:
+    SiteCounters* counters = nullptr;
+    std::chrono::steady_clock::time_point start;
+    std::uint64_t allocationsAtStart = 0;
+    std::uint64_t items = 1;
+
+public:
+    // batchItems: how many items the call handles, for a call that processes a whole batch
+    explicit ScopedCall([[maybe_unused]] const CallSite& site, [[maybe_unused]] std::uint64_t batchItems = 1) {
+        if constexpr (kMetricsEnabled) {
+            items = batchItems;
+            // The thread's counters and ring are allocated on its first call; that is not the call's allocation
+            counters = &site.localCounters();
+            EventLog::instance().attachThread();
+            allocationsAtStart = threadAllocations;
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedCall() {
+        if constexpr (kMetricsEnabled) {
+            auto elapsed =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            std::uint64_t allocations = threadAllocations - allocationsAtStart;
+            CallSite::record(*counters, static_cast<std::uint64_t>(elapsed.count()), allocations, items);
+        }
+    }
+
+    ScopedCall(const ScopedCall&) = delete;
+    ScopedCall& operator=(const ScopedCall&) = delete;
+};
+
+// --- Export ---
+
+// Call-site names are identifiers, but quotes and backslashes are escaped all the same
+inline std::string escapeLabel(std::string_view text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c == '\n' ? ' ' : c;
+    }
+    return escaped;
+}
+
+// Prometheus text exposition format
+inline void writePrometheus(std::ostream& out) {
+    std::vector<CallSiteStats> sites = MetricsRegistry::instance().snapshot();
+
+    out << "# HELP pattern_calls_total Calls through an instrumented call site\n"
+        << "# TYPE pattern_calls_total counter\n";
+    for (const CallSiteStats& site : sites) {
+        out << "pattern_calls_total{site=\"" << escapeLabel(site.name) << "\"} " << site.calls << '\n';
+    }
+
+    out << "# HELP pattern_items_total Items processed by the call site, counting every item of a batched call\n"
+        << "# TYPE pattern_items_total counter\n";
+    for (const CallSiteStats& site : sites) {
+        out << "pattern_items_total{site=\"" << escapeLabel(site.name) << "\"} " << site.items << '\n';
+    }
+
+    out << "# HELP pattern_allocations_total Heap allocations made inside the call site\n"
+        << "# TYPE pattern_allocations_total counter\n";
+    for (const CallSiteStats& site : sites) {
+        out << "pattern_allocations_total{site=\"" << escapeLabel(site.name) << "\"} " << site.allocations << '\n';
+    }
+
+    out << "# HELP pattern_call_duration_ns Time spent per call in nanoseconds\n"
+        << "# TYPE pattern_call_duration_ns histogram\n";
+    for (const CallSiteStats& site : sites) {
+        std::string label = escapeLabel(site.name);
+        std::uint64_t cumulative = 0;
+        for (std::size_t bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+            cumulative += site.latency[bucket];
+            out << "pattern_call_duration_ns_bucket{site=\"" << label << "\",le=\"";
+            if (bucket + 1 < kLatencyBuckets) {
+                out << latencyBucketBound(bucket);
+            } else {
+                out << "+Inf";
+            }
+            out << "\"} " << cumulative << '\n';
+        }
+        out << "pattern_call_duration_ns_sum{site=\"" << label << "\"} " << site.totalNs << '\n'
+            << "pattern_call_duration_ns_count{site=\"" << label << "\"} " << site.calls << '\n';
+    }
+
+    EventLog& log = EventLog::instance();
+    out << "# HELP pattern_log_records_total Events accepted by the event log\n"
+        << "# TYPE pattern_log_records_total counter\n"
+        << "pattern_log_records_total " << log.writtenCount() << '\n'
+        << "# HELP pattern_log_dropped_total Events dropped because a thread's ring was full\n"
+        << "# TYPE pattern_log_dropped_total counter\n"
+        << "pattern_log_dropped_total " << log.droppedCount() << '\n';
+}
+
+// One JSON object: {"call_sites": [...], "log": {...}}, latency buckets keyed by their upper bound in ns
+inline void writeJson(std::ostream& out) {
+    std::vector<CallSiteStats> sites = MetricsRegistry::instance().snapshot();
+
+    out << "{\"call_sites\": [";
+    for (std::size_t i = 0; i < sites.size(); ++i) {
+        const CallSiteStats& site = sites[i];
+        out << (i == 0 ? "\n" : ",\n") << "  {\"site\": \"" << escapeLabel(site.name) << "\", \"calls\": " << site.calls
+            << ", \"items\": " << site.items << ", \"allocations\": " << site.allocations
+            << ", \"total_ns\": " << site.totalNs << ", \"mean_ns\": " << site.meanNs() << ", \"latency_ns\": {";
+        bool first = true;
+        for (std::size_t bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+            if (site.latency[bucket] == 0) {
+                continue;  // Sparse: most calls land in two or three buckets
+            }
+            out << (first ? "" : ", ") << '"';
+            if (bucket + 1 < kLatencyBuckets) {
+                out << latencyBucketBound(bucket);
+            } else {
+                out << "+Inf";
+            }
+            out << "\": " << site.latency[bucket];
+            first = false;
+        }
+        out << "}}";
+    }
+
+    EventLog& log = EventLog::instance();
+    out << (sites.empty() ? "" : "\n") << "], \"log\": {\"records\": " << log.writtenCount()
+        << ", \"dropped\": " << log.droppedCount() << "}}\n";
+}
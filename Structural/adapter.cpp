@@ -38,71 +38,124 @@ Real-World Example:
 Power Adapter: In the real world, a power adapter allows a device with one type of plug to
                connect to an outlet with a different type of socket.
 
-*/
-#include <iostream>
-#include <string>
-
-// Target interface (what the client expects)
-class MediaPlayer {
-public:
-    virtual void playAudio(const std::string& audioType, const std::string& fileName) = 0;
-    virtual ~MediaPlayer() = default;
-};
-
-// Adaptee (existing class with incompatible interface)
-class VideoPlayer {
-public:
-    void playVideo(const std::string& videoType, const std::string& fileName) {
-        if (videoType == "mp4") {
-            std::cout << "Playing mp4 video: " << fileName << std::endl;
-        } else {
-            std::cout << "Unsupported video format: " << videoType << std::endl;
-        }
-    }
-};
+Reusable Adapters and Format Dispatch:
+The original AudioPlayer created a MediaAdapter with new, which in turn created a VideoPlayer with new, and deleted
+both after every mp4 request. If playAudio threw in between, both leaked. Now:
+- MediaAdapter holds its VideoPlayer by value.
+- AudioPlayer owns an AdapterRegistry, which builds each format's adapter the first time it is needed and reuses it
+  for every later request.
+- Format codes are parsed once into a MediaFormat enum. formatKey() packs a short code into one integer (a perfect
+  hash for codes of up to four characters), so parseFormat() is a single switch. play(MediaFormat, fileName) lets
+  players pass the parsed format along instead of comparing strings again.
+PerCallAudioPlayer keeps the original per-call behaviour as the baseline for the throughput benchmark.
+
+Streaming Playback:
+playAudio(type, fileName) takes a whole file at once. playFrame(format, frame) takes one std::span<const std::byte>
+frame of a stream instead, and MediaAdapter adapts it frame by frame to VideoPlayer::playVideoFrame().
+MediaStreamPipeline connects three stages:
+- The calling thread reads fixed-size chunks of the input.
+- A decode thread turns chunks into frames.
+- An adapt thread passes each frame to the player.
+The stages are linked by bounded FrameRings, which are single-producer, single-consumer rings of pre-allocated slots.
+Stages read and write the slots in place. When a ring is full, the stage feeding it waits, so a slow player slows
+down reading instead of letting buffers grow. Memory use is two rings' worth of slots, whatever the file size. An
+exception in any stage stops the pipeline and is rethrown from play().
 
-// Adapter (makes Adaptee compatible with Target)
-class MediaAdapter : public MediaPlayer {
-private:
-    VideoPlayer* videoPlayer;
+*/
+#include "adapter.h"
 
-public:
-    MediaAdapter() {
-        videoPlayer = new VideoPlayer();  // Adaptee
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Plays a million requests of mixed mp3/mp4/avi traffic through the baseline and the registry-backed player
+void runAdapterBenchmark() {
+    const std::size_t requests = 1'000'000;
+    std::ostream sink(nullptr);  // Discards the playback messages
+    const std::array<std::string, 3> types = {"mp3", "mp4", "avi"};
+    std::vector<std::string> audioTypes(requests);
+    std::uint32_t state = 2463534242u;
+    for (std::string& type : audioTypes) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        type = types[state % types.size()];
     }
+    const std::string fileName = "clip";
 
-    ~MediaAdapter() {
-        delete videoPlayer;
-    }
+    auto measure = [&](const char* name, MediaPlayer& player) {
+        auto begin = std::chrono::steady_clock::now();
+        for (const std::string& type : audioTypes) {
+            player.playAudio(type, fileName);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << name << requests / seconds / 1e6 << " M requests/s\n";
+    };
+
+    PerCallAudioPlayer perCall(sink);
+    AudioPlayer pooled(sink);
+    std::cout << "\nMixed mp3/mp4/avi traffic, " << requests << " requests:\n";
+    measure("adapter per call, string compares: ", perCall);
+    measure("adapter registry, format switch:   ", pooled);
+}
 
-    void playAudio(const std::string& audioType, const std::string& fileName) override {
-        if (audioType == "mp4") {
-            videoPlayer->playVideo(audioType, fileName);  // Adapt the call
-        } else {
-            std::cout << "Unsupported audio format: " << audioType << std::endl;
+// Streams a 256 MiB mp4 file through the pipeline and compares it with loading the whole file and then playing it
+void runStreamingBenchmark() {
+    const std::size_t fileBytes = 256 * 1024 * 1024;
+    const std::string path = (std::filesystem::temp_directory_path() / "adapter_stream.mp4").string();
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        std::vector<char> block(1024 * 1024);
+        for (std::size_t i = 0; i < block.size(); ++i) {
+            block[i] = static_cast<char>(i * 7);
+        }
+        for (std::size_t written = 0; written < fileBytes; written += block.size()) {
+            out.write(block.data(), static_cast<std::streamsize>(block.size()));
         }
     }
-};
-
-// Client class that uses the MediaPlayer interface
-class AudioPlayer : public MediaPlayer {
-private:
-    MediaAdapter* mediaAdapter;
-
-public:
-    void playAudio(const std::string& audioType, const std::string& fileName) override {
-        if (audioType == "mp3") {
-            std::cout << "Playing mp3 audio: " << fileName << std::endl;
-        } else if (audioType == "mp4") {
-            // Use the adapter to play mp4 files
-            mediaAdapter = new MediaAdapter();
-            mediaAdapter->playAudio(audioType, fileName);
-            delete mediaAdapter;
-        } else {
-            std::cout << "Unsupported format: " << audioType << std::endl;
+    // Stand-in for real decoding: a byte-wise transform of the chunk
+    auto decode = [](std::span<const std::byte> chunk, std::span<std::byte> out) {
+        for (std::size_t i = 0; i < chunk.size(); ++i) {
+            out[i] = chunk[i] ^ std::byte{0x5a};
         }
+        return chunk.size();
+    };
+    std::ostream sink(nullptr);
+
+    std::cout << "\nPlaying a " << fileBytes / (1024 * 1024) << " MiB mp4 stream through the adapter ("
+              << std::thread::hardware_concurrency() << " hardware threads):\n";
+    {
+        AudioPlayer player(sink);
+        auto begin = std::chrono::steady_clock::now();
+        std::ifstream in(path, std::ios::binary);
+        std::vector<std::byte> whole(fileBytes);
+        in.read(reinterpret_cast<char*>(whole.data()), static_cast<std::streamsize>(whole.size()));
+        std::vector<std::byte> decoded(fileBytes);
+        const std::size_t frameBytes = 64 * 1024;
+        for (std::size_t offset = 0; offset < fileBytes; offset += frameBytes) {
+            std::span<const std::byte> chunk = std::span<const std::byte>(whole).subspan(offset, frameBytes);
+            decode(chunk, std::span<std::byte>(decoded).subspan(offset, frameBytes));
+            player.playFrame(MediaFormat::Mp4, std::span<const std::byte>(decoded).subspan(offset, frameBytes));
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << "load whole file, then play: " << ms << " ms, " << (whole.size() + decoded.size()) / (1024 * 1024)
+                  << " MiB buffered\n";
+    }
+    {
+        AudioPlayer player(sink);
+        MediaStreamPipeline pipeline;
+        auto begin = std::chrono::steady_clock::now();
+        std::ifstream in(path, std::ios::binary);
+        StreamStats stats = pipeline.play(in, MediaFormat::Mp4, player, decode);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << "streaming pipeline:         " << ms << " ms, " << stats.bufferBytes / 1024 << " KiB buffered, "
+                  << stats.frames << " frames, " << stats.readStalls << " read stalls, " << stats.decodeStalls
+                  << " decode stalls\n";
     }
-};
+    std::filesystem::remove(path);
+}
 
 int main() {
     AudioPlayer audioPlayer;
@@ -116,5 +169,16 @@ int main() {
     // Trying to play an unsupported file format
     audioPlayer.playAudio("avi", "video.avi");
 
+    // Stream an mp4 frame by frame through the same adapter
+    std::istringstream movie(std::string(200'000, 'x'));
+    StreamStats stats = MediaStreamPipeline(32 * 1024, 4).play(movie, MediaFormat::Mp4, audioPlayer);
+    auto* adapter = static_cast<MediaAdapter*>(audioPlayer.adapterFor(MediaFormat::Mp4));
+    logEvent<LogLevel::Info>("Streamed ", stats.bytesRead, " bytes as ", stats.frames,
+                             " frames; the video player rendered ", adapter->getVideoPlayer().framesPlayed(), " frames");
+
+    flushEvents();  // The benchmarks print to std::cout directly
+    runAdapterBenchmark();
+    runStreamingBenchmark();
+
     return 0;
 }
@@ -0,0 +1,443 @@
+// Adapter pattern classes. adapter.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Media formats known to the players; dispatch switches on these instead of comparing strings
+enum class MediaFormat : std::uint8_t { Mp3, Mp4, Avi, Unknown };
+
+inline constexpr std::size_t kMediaFormatCount = static_cast<std::size_t>(MediaFormat::Unknown) + 1;
+
+// Packs a format code of up to four characters into one integer. Distinct short codes get distinct keys
+// (a perfect hash), so parsing a format is one switch instead of a chain of string comparisons.
+constexpr std::uint32_t formatKey(std::string_view code) {
+    std::uint32_t key = 0;
+    for (std::size_t i = 0; i < code.size() && i < 4; ++i) {
+        key |= std::uint32_t(static_cast<unsigned char>(code[i])) << (8 * i);
+    }
+    return code.size() <= 4 ? key : 0;
+}
+
+constexpr MediaFormat parseFormat(std::string_view code) {
+    switch (formatKey(code)) {
+        case formatKey("mp3"): return MediaFormat::Mp3;
+        case formatKey("mp4"): return MediaFormat::Mp4;
+        case formatKey("avi"): return MediaFormat::Avi;
+        default: return MediaFormat::Unknown;
+    }
+}
+
+constexpr std::string_view formatName(MediaFormat format) {
+    constexpr std::array<std::string_view, kMediaFormatCount> names = {"mp3", "mp4", "avi", "unknown"};
+    return names[static_cast<std::size_t>(format)];
+}
+
+static_assert(parseFormat("mp4") == MediaFormat::Mp4 && parseFormat("mp44") == MediaFormat::Unknown);
+
+// Target interface (what the client expects)
+class MediaPlayer {
+public:
+    virtual void playAudio(const std::string& audioType, const std::string& fileName) = 0;
+
+    // Play an already parsed format; players that dispatch on MediaFormat override this to skip the string
+    virtual void play(MediaFormat format, const std::string& fileName) {
+        playAudio(std::string(formatName(format)), fileName);
+    }
+
+    // Play one frame of a stream; players that cannot stream a format throw std::invalid_argument
+    virtual void playFrame(MediaFormat format, std::span<const std::byte> frame) {
+        (void)frame;
+        throw std::invalid_argument("cannot stream " + std::string(formatName(format)));
+    }
+
+    virtual ~MediaPlayer() = default;
+};
+
+// Adaptee (existing class with incompatible interface)
+class VideoPlayer {
+private:
+    std::ostream& output;
+    std::size_t frames = 0;
+    std::uint64_t checksum = 0;
+
+public:
+    VideoPlayer(std::ostream& out = eventStream()) : output(out) {}
+
+    void playVideo(const std::string& videoType, const std::string& fileName) {
+        static CallSite site("VideoPlayer::playVideo");
+        ScopedCall call(site);
+        if (videoType == "mp4") {
+            localStream(output) << "Playing mp4 video: " << fileName << '\n';
+        } else {
+            localStream(output) << "Unsupported video format: " << videoType << '\n';
+        }
+    }
+
+    void playVideo(MediaFormat format, const std::string& fileName) {
+        static CallSite site("VideoPlayer::playVideo");
+        ScopedCall call(site);
+        if (format == MediaFormat::Mp4) {
+            localStream(output) << "Playing mp4 video: " << fileName << '\n';
+        } else {
+            localStream(output) << "Unsupported video format: " << formatName(format) << '\n';
+        }
+    }
+
+    // Streaming entry point of the adaptee: renders one decoded mp4 frame
+    void playVideoFrame(std::span<const std::byte> frame) {
+        ++frames;
+        for (std::byte value : frame) {
+            checksum = checksum * 31 + std::to_integer<std::uint8_t>(value);
+        }
+    }
+
+    std::size_t framesPlayed() const {
+        return frames;
+    }
+
+    std::uint64_t frameChecksum() const {
+        return checksum;
+    }
+};
+
+// Adapter (makes Adaptee compatible with Target)
+class MediaAdapter : public MediaPlayer {
+private:
+    VideoPlayer videoPlayer;  // Adaptee, held by value: no separate allocation and nothing to leak
+    std::ostream& output;
+
+public:
+    MediaAdapter(std::ostream& out = eventStream()) : videoPlayer(out), output(out) {}
+
+    void playAudio(const std::string& audioType, const std::string& fileName) override {
+        play(parseFormat(audioType), fileName);
+    }
+
+    void play(MediaFormat format, const std::string& fileName) override {
+        if (format == MediaFormat::Mp4) {
+            videoPlayer.playVideo(format, fileName);  // Adapt the call
+        } else {
+            localStream(output) << "Unsupported audio format: " << formatName(format) << '\n';
+        }
+    }
+
+    void playFrame(MediaFormat format, std::span<const std::byte> frame) override {
+        if (format != MediaFormat::Mp4) {
+            MediaPlayer::playFrame(format, frame);
+        }
+        videoPlayer.playVideoFrame(frame);  // Adapt frame by frame, still pointing into the pipeline's buffer
+    }
+
+    const VideoPlayer& getVideoPlayer() const {
+        return videoPlayer;
+    }
+};
+
+// Builds at most one adapter per format, on first use, and hands the same instance out afterwards
+class AdapterRegistry {
+public:
+    using Factory = std::unique_ptr<MediaPlayer> (*)(std::ostream&);
+
+private:
+    std::ostream& output;
+    std::array<Factory, kMediaFormatCount> factories{};
+    std::array<std::unique_ptr<MediaPlayer>, kMediaFormatCount> adapters;
+
+public:
+    AdapterRegistry(std::ostream& out = eventStream()) : output(out) {}
+
+    void registerAdapter(MediaFormat format, Factory factory) {
+        factories[static_cast<std::size_t>(format)] = factory;
+    }
+
+    // The adapter for a format, or nullptr if none is registered
+    MediaPlayer* find(MediaFormat format) {
+        std::size_t slot = static_cast<std::size_t>(format);
+        if (!adapters[slot] && factories[slot]) {
+            adapters[slot] = factories[slot](output);
+        }
+        return adapters[slot].get();
+    }
+};
+
+// Client class that uses the MediaPlayer interface
+class AudioPlayer : public MediaPlayer {
+private:
+    std::ostream& output;
+    AdapterRegistry adapters;
+    std::size_t audioFrames = 0;
+
+public:
+    AudioPlayer(std::ostream& out = eventStream()) : output(out), adapters(out) {
+        adapters.registerAdapter(MediaFormat::Mp4, [](std::ostream& os) -> std::unique_ptr<MediaPlayer> {
+            return std::make_unique<MediaAdapter>(os);
+        });
+    }
+
+    void playAudio(const std::string& audioType, const std::string& fileName) override {
+        play(parseFormat(audioType), fileName);
+    }
+
+    void play(MediaFormat format, const std::string& fileName) override {
+        static CallSite site("AudioPlayer::play");
+        ScopedCall call(site);
+        if (format == MediaFormat::Mp3) {
+            localStream(output) << "Playing mp3 audio: " << fileName << '\n';
+        } else if (MediaPlayer* adapter = adapters.find(format)) {
+            // Use the adapter to play mp4 files
+            adapter->play(format, fileName);
+        } else {
+            localStream(output) << "Unsupported format: " << formatName(format) << '\n';
+        }
+    }
+
+    void playFrame(MediaFormat format, std::span<const std::byte> frame) override {
+        if (format == MediaFormat::Mp3) {
+            ++audioFrames;
+        } else if (MediaPlayer* adapter = adapters.find(format)) {
+            adapter->playFrame(format, frame);
+        } else {
+            MediaPlayer::playFrame(format, frame);
+        }
+    }
+
+    std::size_t audioFramesPlayed() const {
+        return audioFrames;
+    }
+
+    // The adapter serving a format, if one has been registered (built on first use)
+    MediaPlayer* adapterFor(MediaFormat format) {
+        return adapters.find(format);
+    }
+};
+
+// Baseline for the throughput benchmark: the original client, comparing strings and building an adapter on every call
+class PerCallAudioPlayer : public MediaPlayer {
+private:
+    std::ostream& output;
+
+public:
+    PerCallAudioPlayer(std::ostream& out = eventStream()) : output(out) {}
+
+    void playAudio(const std::string& audioType, const std::string& fileName) override {
+        static CallSite site("PerCallAudioPlayer::playAudio");
+        ScopedCall call(site);
+        if (audioType == "mp3") {
+            localStream(output) << "Playing mp3 audio: " << fileName << '\n';
+        } else if (audioType == "mp4") {
+            auto mediaAdapter = std::make_unique<MediaAdapter>(output);
+            mediaAdapter->playAudio(audioType, fileName);
+        } else {
+            localStream(output) << "Unsupported format: " << audioType << '\n';
+        }
+    }
+};
+
+// Bounded single-producer, single-consumer ring of fixed-size frame slots. The producer fills a slot in place and
+// the consumer reads it in place, so frames are never copied between stages; a full ring blocks the producer.
+class FrameRing {
+private:
+    std::vector<std::byte> storage;
+    std::vector<std::size_t> lengths;
+    std::size_t slotCount;
+    std::size_t frameBytes;
+    std::size_t head = 0;  // Next slot to read
+    std::size_t tail = 0;  // Next slot to write
+    bool closed = false;
+    std::size_t fullWaits = 0;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+
+    std::span<std::byte> slot(std::size_t index) {
+        return std::span<std::byte>(storage).subspan((index % slotCount) * frameBytes, frameBytes);
+    }
+
+public:
+    FrameRing(std::size_t slots, std::size_t bytesPerFrame)
+        : storage(slots * bytesPerFrame), lengths(slots), slotCount(slots), frameBytes(bytesPerFrame) {}
+
+    // Free slot to fill, waiting while the ring is full; empty once the ring is closed
+    std::span<std::byte> beginWrite() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (tail - head == slotCount && !closed) {
+            ++fullWaits;
+            notFull.wait(lock, [this] { return tail - head < slotCount || closed; });
+        }
+        return closed ? std::span<std::byte>() : slot(tail);
+    }
+
+    // Publish the slot returned by beginWrite() holding `bytes` bytes
+    void endWrite(std::size_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lengths[tail % slotCount] = bytes;
+            ++tail;
+        }
+        notEmpty.notify_one();
+    }
+
+    // Oldest filled frame, waiting while the ring is empty; std::nullopt once closed and drained
+    std::optional<std::span<const std::byte>> beginRead() {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return head != tail || closed; });
+        if (head == tail) {
+            return std::nullopt;
+        }
+        return slot(head).first(lengths[head % slotCount]);
+    }
+
+    // Hand the frame returned by beginRead() back to the producer
+    void endRead() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++head;
+        }
+        notFull.notify_one();
+    }
+
+    // No more frames will be written; readers drain what is left, and a blocked writer gets an empty slot
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    std::size_t capacityBytes() const {
+        return storage.size();
+    }
+
+    std::size_t producerWaits() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return fullWaits;
+    }
+};
+
+struct StreamStats {
+    std::size_t frames = 0;
+    std::size_t bytesRead = 0;
+    std::size_t bufferBytes = 0;  // Memory held by the pipeline, independent of the stream's length
+    std::size_t readStalls = 0;  // Times reading waited for the decoder (backpressure)
+    std::size_t decodeStalls = 0;  // Times decoding waited for the player
+};
+
+// Plays a stream frame by frame: the calling thread reads fixed-size chunks from the input, a decode thread turns
+// them into frames and an adapt thread hands each frame to player.playFrame(). The stages are connected by bounded
+// FrameRings, so memory use is fixed and reading overlaps with decoding and playback.
+class MediaStreamPipeline {
+public:
+    // Decodes one input chunk into `out` (at most frameBytes bytes) and returns the decoded size; a size larger than
+    // `out` fails the stream with std::length_error
+    using Decoder = std::function<std::size_t(std::span<const std::byte> chunk, std::span<std::byte> out)>;
+
+private:
+    std::size_t frameBytes;
+    std::size_t ringSlots;
+
+public:
+    MediaStreamPipeline(std::size_t bytesPerFrame = 64 * 1024, std::size_t slots = 8)
+        : frameBytes(bytesPerFrame), ringSlots(slots) {}
+
+    // Identity decoder: the frame is the chunk
+    static std::size_t copyDecoder(std::span<const std::byte> chunk, std::span<std::byte> out) {
+        std::copy(chunk.begin(), chunk.end(), out.begin());
+        return chunk.size();
+    }
+
+    // Stream the input to the player; exceptions from reading, the decoder or the player are rethrown here
+    StreamStats play(std::istream& input, MediaFormat format, MediaPlayer& player, Decoder decode = copyDecoder) {
+        FrameRing chunks(ringSlots, frameBytes);
+        FrameRing frames(ringSlots, frameBytes);
+        StreamStats stats;
+        stats.bufferBytes = chunks.capacityBytes() + frames.capacityBytes();
+        std::exception_ptr failure;
+        std::mutex failureMutex;
+        auto fail = [&] {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            chunks.close();
+            frames.close();
+        };
+
+        std::thread decoder([&] {
+            try {
+                while (auto chunk = chunks.beginRead()) {
+                    std::span<std::byte> out = frames.beginWrite();
+                    if (out.empty()) {
+                        break;  // The player stopped
+                    }
+                    std::size_t decoded = decode(*chunk, out);
+                    if (decoded > out.size()) {
+                        throw std::length_error("decoder returned more bytes than the frame holds");
+                    }
+                    frames.endWrite(decoded);
+                    chunks.endRead();
+                }
+            } catch (...) {
+                fail();
+            }
+            frames.close();
+        });
+        std::thread adapter([&] {
+            try {
+                while (auto frame = frames.beginRead()) {
+                    player.playFrame(format, *frame);
+                    ++stats.frames;
+                    frames.endRead();
+                }
+            } catch (...) {
+                fail();
+            }
+        });
+
+        try {
+            for (;;) {
+                std::span<std::byte> slot = chunks.beginWrite();
+                if (slot.empty()) {
+                    break;  // A later stage failed
+                }
+                input.read(reinterpret_cast<char*>(slot.data()), static_cast<std::streamsize>(slot.size()));
+                std::size_t bytes = static_cast<std::size_t>(input.gcount());
+                if (bytes == 0) {
+                    break;
+                }
+                stats.bytesRead += bytes;
+                chunks.endWrite(bytes);
+            }
+        } catch (...) {
+            fail();  // E.g. an istream with exceptions() set; the stages still have to be joined
+        }
+        chunks.close();
+        decoder.join();
+        adapter.join();
+
+        stats.readStalls = chunks.producerWaits();
+        stats.decodeStalls = frames.producerWaits();
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+        return stats;
+    }
+};
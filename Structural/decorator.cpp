@@ -44,75 +44,113 @@ Text Editing: In a text editor, decorators might be used to add functionality li
 Instead of creating a new class for every combination of bold, italic, and underline,
 you can use decorators to apply these styles dynamically.
 
-*/
-#include <iostream>
-#include <string>
-#include <memory>  // For smart pointers
-
-// Component interface
-class Coffee {
-public:
-    virtual std::string getDescription() const = 0;  // To get the description of the coffee
-    virtual double cost() const = 0;  // To get the cost of the coffee
-    virtual ~Coffee() = default;  // Virtual destructor
-};
-
-// ConcreteComponent: Basic coffee without any add-ons
-class SimpleCoffee : public Coffee {
-public:
-    std::string getDescription() const override {
-        return "Simple Coffee";
-    }
-
-    double cost() const override {
-        return 5.0;  // Base cost of the coffee
-    }
-};
+Compile-Time and Flattened Decorators:
+Each cost() and getDescription() on a decorated Coffee walks the chain of heap nodes with one virtual call per layer,
+and getDescription() builds a new std::string at every layer. Two alternatives remove that per-call work:
+- Decorated<SimpleCoffee, Milk, Sugar> composes the add-ons at compile time. Milk and Sugar are plain tags that carry
+  a name and a price, and fold expressions over the pack produce the total cost and the full description as
+  constants. staticCost() and description() are constexpr. The class is a final Coffee, so it still works wherever
+  the interface is expected, and calls on the concrete type are devirtualized.
+- flatten(coffee) collapses an existing runtime chain into one FlattenedCoffee node. It prices the chain and builds
+  its description once, then answers every later call from those cached values.
+
+Cached Decorator Chains:
+The runtime chain no longer recomputes anything per call. The wrapped component cannot change after construction,
+so each CoffeeDecorator stores its total cost and description length when it is built, from the add-on name and
+price its subclass passes in. cost() then just returns the stored value. getDescription() allocates one string of
+exactly descriptionLength() characters and has every layer writeDescription() its part straight into it.
+appendDescription(out) does the same into a caller's string, so it needs no allocation when out has room.
+RecomputingDecorator keeps the original behaviour as the baseline for the depth-20 benchmark.
 
-// Decorator abstract class (must implement the Coffee interface)
-class CoffeeDecorator : public Coffee {
-protected:
-    std::unique_ptr<Coffee> coffee;  // Pointer to the wrapped component
-
-public:
-    CoffeeDecorator(std::unique_ptr<Coffee> coffee) : coffee(std::move(coffee)) {}
-
-    virtual std::string getDescription() const override {
-        return coffee->getDescription();
-    }
+*/
+#include "decorator.h"
 
-    virtual double cost() const override {
-        return coffee->cost();
-    }
-};
+#include "counting_allocator.h"
 
-// ConcreteDecorator: Adding Milk to the coffee
-class MilkDecorator : public CoffeeDecorator {
-public:
-    MilkDecorator(std::unique_ptr<Coffee> coffee) : CoffeeDecorator(std::move(coffee)) {}
+#include <chrono>
+#include <iostream>
 
-    std::string getDescription() const override {
-        return coffee->getDescription() + ", Milk";
+// Prices a ten-layer order through the heap chain, the flattened node and the compile-time composition
+void runDecoratorBenchmark() {
+    const int calls = 1'000'000;
+    std::unique_ptr<Coffee> chain = std::make_unique<SimpleCoffee>();
+    for (int layer = 0; layer < 5; ++layer) {
+        chain = std::make_unique<MilkDecorator>(std::move(chain));
+        chain = std::make_unique<SugarDecorator>(std::move(chain));
     }
+    std::unique_ptr<Coffee> flat = flatten(*chain);
+    std::unique_ptr<Coffee> composed = std::make_unique<Decorated<SimpleCoffee, Milk, Sugar, Milk, Sugar, Milk, Sugar,
+                                                                  Milk, Sugar, Milk, Sugar>>();
+
+    auto measure = [&](const char* label, const Coffee& coffee) {
+        volatile double total = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i) {
+            total = total + coffee.cost();
+        }
+        auto middle = std::chrono::steady_clock::now();
+        std::size_t length = 0;
+        for (int i = 0; i < calls; ++i) {
+            length += coffee.getDescription().size();
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::cout << label << std::chrono::duration<double, std::nano>(middle - begin).count() / calls << " ns cost(), "
+                  << std::chrono::duration<double, std::nano>(end - middle).count() / calls << " ns getDescription() ("
+                  << total / calls << ", " << length / calls << " chars)\n";
+    };
+
+    std::cout << "\nTen add-ons, " << calls << " calls each (through the Coffee interface):\n";
+    measure("unique_ptr chain: ", *chain);
+    measure("flattened:        ", *flat);
+    measure("Decorated<...>:   ", *composed);
+}
 
-    double cost() const override {
-        return coffee->cost() + 1.0;  // Adding the cost of milk
+// Runs call() `calls` times and reports ns and heap allocations per call
+template <typename Call>
+void measureDecoratorCall(const char* name, int calls, Call call) {
+    std::size_t allocationsBefore = heapAllocationCount();
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i) {
+        call();
     }
-};
-
-// ConcreteDecorator: Adding Sugar to the coffee
-class SugarDecorator : public CoffeeDecorator {
-public:
-    SugarDecorator(std::unique_ptr<Coffee> coffee) : CoffeeDecorator(std::move(coffee)) {}
+    auto end = std::chrono::steady_clock::now();
+    std::size_t allocations = heapAllocationCount() - allocationsBefore;
+    std::cout << name << std::chrono::duration<double, std::nano>(end - begin).count() / calls << " ns, "
+              << double(allocations) / calls << " allocations per call\n";
+}
 
-    std::string getDescription() const override {
-        return coffee->getDescription() + ", Sugar";
+// Depth-20 chain: the recomputing baseline against the caching CoffeeDecorator
+void runCachedChainBenchmark() {
+    const int depth = 20;
+    const int calls = 200'000;
+    std::unique_ptr<Coffee> recomputing = std::make_unique<SimpleCoffee>();
+    std::unique_ptr<Coffee> cached = std::make_unique<SimpleCoffee>();
+    for (int layer = 0; layer < depth; ++layer) {
+        if (layer % 2 == 0) {
+            recomputing = std::make_unique<RecomputingDecorator>(std::move(recomputing), "Milk", 1.0);
+            cached = std::make_unique<MilkDecorator>(std::move(cached));
+        } else {
+            recomputing = std::make_unique<RecomputingDecorator>(std::move(recomputing), "Sugar", 0.5);
+            cached = std::make_unique<SugarDecorator>(std::move(cached));
+        }
     }
 
-    double cost() const override {
-        return coffee->cost() + 0.5;  // Adding the cost of sugar
-    }
-};
+    volatile double price = 0;
+    std::size_t length = 0;
+    std::string buffer;
+    buffer.reserve(cached->descriptionLength());
+    std::cout << "\nDecorator chain of depth " << depth << " (" << cached->descriptionLength() << "-char description):\n";
+    measureDecoratorCall("recomputing cost():           ", calls, [&] { price = recomputing->cost(); });
+    measureDecoratorCall("cached cost():                ", calls, [&] { price = cached->cost(); });
+    measureDecoratorCall("recomputing getDescription(): ", calls, [&] { length += recomputing->getDescription().size(); });
+    measureDecoratorCall("cached getDescription():      ", calls, [&] { length += cached->getDescription().size(); });
+    measureDecoratorCall("cached appendDescription():   ", calls, [&] {
+        buffer.clear();
+        cached->appendDescription(buffer);
+        length += buffer.size();
+    });
+    std::cout << "(checksum " << price << ", " << length / (3 * calls) << " chars)\n";
+}
 
 // Client code
 int main() {
@@ -131,5 +169,19 @@ int main() {
     std::cout << "Description: " << myCoffee->getDescription() << std::endl;
     std::cout << "Cost: $" << myCoffee->cost() << std::endl;
 
+    // The same order composed at compile time, and the runtime chain collapsed into one node
+    constexpr double composedCost = Decorated<SimpleCoffee, Milk, Sugar>::staticCost();
+    std::cout << "\nCompile-time: " << Decorated<SimpleCoffee, Milk, Sugar>::description() << ", $" << composedCost << std::endl;
+    std::unique_ptr<Coffee> flat = flatten(*myCoffee);
+    std::cout << "Flattened: " << flat->getDescription() << ", $" << flat->cost() << std::endl;
+
+    // Append the description to an existing buffer without temporary strings
+    std::string receipt = "Order: ";
+    myCoffee->appendDescription(receipt);
+    std::cout << receipt << std::endl;
+
+    runDecoratorBenchmark();
+    runCachedChainBenchmark();
+
     return 0;
 }
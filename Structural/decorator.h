@@ -0,0 +1,225 @@
+// Decorator pattern classes. decorator.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <memory>  // For smart pointers
+
+// Component interface
+class Coffee {
+public:
+    virtual std::string getDescription() const = 0;  // To get the description of the coffee
+    virtual double cost() const = 0;  // To get the cost of the coffee
+
+    // Length of getDescription(), so callers can size a buffer once
+    virtual std::size_t descriptionLength() const {
+        return getDescription().size();
+    }
+
+    // Write the description to out, which has room for descriptionLength() chars, and return the end
+    virtual char* writeDescription(char* out) const {
+        std::string text = getDescription();
+        return std::copy(text.begin(), text.end(), out);
+    }
+
+    // Append the description to out with a single resize and no temporary strings
+    void appendDescription(std::string& out) const {
+        std::size_t start = out.size();
+        out.resize(start + descriptionLength());
+        writeDescription(out.data() + start);
+    }
+
+    virtual ~Coffee() = default;  // Virtual destructor
+};
+
+// ConcreteComponent: Basic coffee without any add-ons
+class SimpleCoffee : public Coffee {
+public:
+    static constexpr std::string_view baseDescription = "Simple Coffee";
+    static constexpr double baseCost = 5.0;  // Base cost of the coffee
+
+    std::string getDescription() const override {
+        return std::string(baseDescription);
+    }
+
+    double cost() const override {
+        return baseCost;
+    }
+
+    std::size_t descriptionLength() const override {
+        return baseDescription.size();
+    }
+
+    char* writeDescription(char* out) const override {
+        return std::copy(baseDescription.begin(), baseDescription.end(), out);
+    }
+};
+
+// Decorator abstract class (must implement the Coffee interface)
+// The wrapped component cannot change after construction, so each decorator works out its total cost and
+// description length once, when it is created, instead of walking the chain on every call.
+class CoffeeDecorator : public Coffee {
+protected:
+    std::unique_ptr<Coffee> coffee;  // Pointer to the wrapped component
+    std::string_view addOn;  // Name appended to the description (empty for a pass-through decorator)
+    double cachedCost;
+    std::size_t cachedLength;
+
+public:
+    CoffeeDecorator(std::unique_ptr<Coffee> coffee) : CoffeeDecorator(std::move(coffee), {}, 0.0) {}
+
+    CoffeeDecorator(std::unique_ptr<Coffee> coffee, std::string_view name, double price)
+        : coffee(std::move(coffee)), addOn(name), cachedCost(this->coffee->cost() + price),
+          cachedLength(this->coffee->descriptionLength() + (name.empty() ? 0 : 2 + name.size())) {}
+
+    // One allocation, sized up front, however deep the chain is
+    std::string getDescription() const override {
+        std::string description(cachedLength, '\0');
+        writeDescription(description.data());
+        return description;
+    }
+
+    double cost() const override {
+        return cachedCost;
+    }
+
+    std::size_t descriptionLength() const override {
+        return cachedLength;
+    }
+
+    char* writeDescription(char* out) const override {
+        out = coffee->writeDescription(out);
+        if (!addOn.empty()) {
+            *out++ = ',';
+            *out++ = ' ';
+            out = std::copy(addOn.begin(), addOn.end(), out);
+        }
+        return out;
+    }
+};
+
+// ConcreteDecorator: Adding Milk to the coffee
+class MilkDecorator : public CoffeeDecorator {
+public:
+    MilkDecorator(std::unique_ptr<Coffee> coffee) : CoffeeDecorator(std::move(coffee), "Milk", 1.0) {}  // Adding the cost of milk
+};
+
+// ConcreteDecorator: Adding Sugar to the coffee
+class SugarDecorator : public CoffeeDecorator {
+public:
+    SugarDecorator(std::unique_ptr<Coffee> coffee) : CoffeeDecorator(std::move(coffee), "Sugar", 0.5) {}  // Adding the cost of sugar
+};
+
+// Add-on tags for compile-time composition: the same names and prices as the decorators above
+struct Milk {
+    static constexpr std::string_view name = "Milk";
+    static constexpr double price = 1.0;
+};
+
+struct Sugar {
+    static constexpr std::string_view name = "Sugar";
+    static constexpr double price = 0.5;
+};
+
+// Base coffee with add-ons applied in order, resolved entirely at compile time
+template <typename Base, typename... AddOns>
+class Decorated final : public Coffee {
+private:
+    static constexpr std::size_t textLength = Base::baseDescription.size() + (std::size_t{0} + ... + (2 + AddOns::name.size()));
+
+    static constexpr std::array<char, textLength> descriptionText = [] {
+        std::array<char, textLength> text{};
+        std::size_t length = 0;
+        auto append = [&](std::string_view part) {
+            for (char c : part) {
+                text[length++] = c;
+            }
+        };
+        append(Base::baseDescription);
+        ((append(", "), append(AddOns::name)), ...);
+        return text;
+    }();
+
+public:
+    static constexpr double staticCost() {
+        return Base::baseCost + (0.0 + ... + AddOns::price);
+    }
+
+    static constexpr std::string_view description() {
+        return std::string_view(descriptionText.data(), descriptionText.size());
+    }
+
+    std::string getDescription() const override {
+        return std::string(description());
+    }
+
+    double cost() const override {
+        return staticCost();
+    }
+
+    std::size_t descriptionLength() const override {
+        return textLength;
+    }
+
+    char* writeDescription(char* out) const override {
+        return std::copy(descriptionText.begin(), descriptionText.end(), out);
+    }
+};
+
+static_assert(Decorated<SimpleCoffee, Milk, Sugar>::staticCost() == 6.5);
+static_assert(Decorated<SimpleCoffee, Milk, Sugar>::description() == "Simple Coffee, Milk, Sugar");
+
+// A whole decorator chain collapsed into one node with its cost and description computed once
+class FlattenedCoffee final : public Coffee {
+private:
+    std::string description;
+    double price;
+
+public:
+    FlattenedCoffee(std::string text, double total) : description(std::move(text)), price(total) {}
+
+    std::string getDescription() const override {
+        return description;
+    }
+
+    double cost() const override {
+        return price;
+    }
+
+    std::size_t descriptionLength() const override {
+        return description.size();
+    }
+
+    char* writeDescription(char* out) const override {
+        return std::copy(description.begin(), description.end(), out);
+    }
+};
+
+// Evaluate a chain once and return an equivalent single node; the original chain is left untouched
+inline std::unique_ptr<Coffee> flatten(const Coffee& coffee) {
+    return std::make_unique<FlattenedCoffee>(coffee.getDescription(), coffee.cost());
+}
+
+// Baseline for the depth-20 benchmark: the original decorator, which recomputes the chain on every call
+class RecomputingDecorator final : public Coffee {
+private:
+    std::unique_ptr<Coffee> coffee;
+    std::string_view addOn;
+    double price;
+
+public:
+    RecomputingDecorator(std::unique_ptr<Coffee> inner, std::string_view name, double addOnPrice)
+        : coffee(std::move(inner)), addOn(name), price(addOnPrice) {}
+
+    std::string getDescription() const override {
+        return coffee->getDescription() + ", " + std::string(addOn);
+    }
+
+    double cost() const override {
+        return coffee->cost() + price;
+    }
+};
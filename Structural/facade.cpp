@@ -34,90 +34,59 @@ Operating System Facade: When you click "shutdown" on your computer, the operati
 interacts with various subsystems like file systems, memory management, and hardware controllers to
 gracefully shut down the computer. The user doesn't need to know about these subsystems.
 
-*/
-#include <iostream>
-#include <string>
-
-// Subsystem class: DVD Player
-class DVDPlayer {
-public:
-    void on() {
-        std::cout << "DVD Player is ON." << std::endl;
-    }
-
-    void play(const std::string& movie) {
-        std::cout << "Playing movie: " << movie << std::endl;
-    }
-
-    void off() {
-        std::cout << "DVD Player is OFF." << std::endl;
-    }
-};
-
-// Subsystem class: Projector
-class Projector {
-public:
-    void on() {
-        std::cout << "Projector is ON." << std::endl;
-    }
-
-    void setWideScreenMode() {
-        std::cout << "Projector set to widescreen mode." << std::endl;
-    }
-
-    void off() {
-        std::cout << "Projector is OFF." << std::endl;
-    }
-};
+Orchestrated Startup and Shutdown:
+watchMovie() and endMovie() call every device in sequence, so a scene takes as long as all the warm-ups added up.
+watchMovieAsync() and endMovieAsync() describe the same scenes as steps with dependencies instead, for example:
+the movie plays only after the projector is in widescreen mode, the sound is in surround mode and the DVD player
+is on. SceneOrchestrator runs each step on its own thread (std::async) as soon as the steps it depends on are done.
+A scene then takes as long as its slowest dependency chain. The returned SceneReport gives the measured end-to-end
+time, the time the steps would take in sequence, and the critical path with the names of its steps. If a step
+throws, the steps that depend on it are skipped and the exception is rethrown from run().
+Devices accept a DeviceTiming to simulate warm-up, and an output stream, because they now print from several
+threads. Each message is written in one piece.
 
-// Subsystem class: Sound System
-class SoundSystem {
-public:
-    void on() {
-        std::cout << "Sound System is ON." << std::endl;
-    }
+*/
+#include "facade.h"
 
-    void setSurroundSound() {
-        std::cout << "Sound System set to surround sound." << std::endl;
-    }
+#include <iostream>
 
-    void off() {
-        std::cout << "Sound System is OFF." << std::endl;
-    }
-};
-
-// The Facade class: Home Theater Facade
-class HomeTheaterFacade {
-private:
-    DVDPlayer* dvdPlayer;
-    Projector* projector;
-    SoundSystem* soundSystem;
-
-public:
-    HomeTheaterFacade(DVDPlayer* dvd, Projector* proj, SoundSystem* sound)
-        : dvdPlayer(dvd), projector(proj), soundSystem(sound) {}
-
-    // Simplified method to watch a movie
-    void watchMovie(const std::string& movie) {
-        std::cout << "Setting up the home theater to watch a movie...\n";
-        projector->on();
-        projector->setWideScreenMode();
-
-        soundSystem->on();
-        soundSystem->setSurroundSound();
-
-        dvdPlayer->on();
-        dvdPlayer->play(movie);
+// Prints the timing of one orchestrated scene
+void printSceneReport(const char* scene, const SceneReport& report) {
+    flushEvents();  // The devices' messages come first
+    std::cout << scene << ": " << report.wallMs << " ms end to end, " << report.sequentialMs
+              << " ms if run in sequence, critical path " << report.criticalPathMs << " ms (";
+    for (std::size_t i = 0; i < report.criticalPath.size(); ++i) {
+        std::cout << (i ? " -> " : "") << report.criticalPath[i];
     }
+    std::cout << ")\n";
+}
 
-    // Simplified method to end the movie
-    void endMovie() {
-        std::cout << "Shutting down the home theater...\n";
-        dvdPlayer->off();
-        soundSystem->off();
-        projector->off();
-    }
-};
+// Devices with realistic warm-up times: sequential facade calls against the orchestrated scene
+void runSceneBenchmark() {
+    std::ostream dvdSink(nullptr);  // One discarding stream per device, since devices now run on different threads
+    std::ostream projectorSink(nullptr);
+    std::ostream soundSink(nullptr);
+    DVDPlayer dvd({std::chrono::milliseconds(150), std::chrono::milliseconds(20), std::chrono::milliseconds(60)}, dvdSink);
+    Projector projector({std::chrono::milliseconds(300), std::chrono::milliseconds(50), std::chrono::milliseconds(120)}, projectorSink);
+    SoundSystem sound({std::chrono::milliseconds(200), std::chrono::milliseconds(40), std::chrono::milliseconds(80)}, soundSink);
+    HomeTheaterFacade homeTheater(&dvd, &projector, &sound);
+
+    // Silence the facade's own banner lines while timing
+    std::shared_ptr<EventSink> console = EventLog::instance().setSink(std::make_shared<DiscardEventSink>());
+    auto begin = std::chrono::steady_clock::now();
+    homeTheater.watchMovie("Inception");
+    double sequentialStart = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    begin = std::chrono::steady_clock::now();
+    homeTheater.endMovie();
+    double sequentialEnd = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    EventLog::instance().setSink(console);
+
+    std::cout << "\nHome theater with warm-up times:\n";
+    std::cout << "watchMovie (sequential): " << sequentialStart << " ms\n";
+    printSceneReport("watchMovieAsync        ", homeTheater.watchMovieAsync("Inception"));
+    std::cout << "endMovie (sequential):   " << sequentialEnd << " ms\n";
+    printSceneReport("endMovieAsync          ", homeTheater.endMovieAsync());
+}
 
 // Client code
 int main() {
@@ -135,5 +104,13 @@ int main() {
     // After watching the movie, turn everything off
     homeTheater.endMovie();
 
+    // The same scene with independent steps running concurrently
+    logEvent<LogLevel::Info>("\nOrchestrated scene:");
+    printSceneReport("watchMovieAsync", homeTheater.watchMovieAsync("Inception"));
+    printSceneReport("endMovieAsync", homeTheater.endMovieAsync());
+
+    flushEvents();  // The benchmarks print to std::cout directly
+    runSceneBenchmark();
+
     return 0;
 }
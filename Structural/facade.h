@@ -0,0 +1,260 @@
+// Facade pattern classes. facade.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include "instrumentation.h"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// How long a device takes to power on, to apply a setting and to power off (zero for the instant demo devices)
+struct DeviceTiming {
+    std::chrono::milliseconds on{0};
+    std::chrono::milliseconds configure{0};
+    std::chrono::milliseconds off{0};
+};
+
+// Subsystem class: DVD Player
+class DVDPlayer {
+private:
+    DeviceTiming timing;
+    std::ostream& output;
+
+public:
+    DVDPlayer(DeviceTiming times = {}, std::ostream& out = eventStream()) : timing(times), output(out) {}
+
+    void on() {
+        std::this_thread::sleep_for(timing.on);
+        localStream(output) << "DVD Player is ON.\n" << std::flush;
+    }
+
+    void play(const std::string& movie) {
+        std::this_thread::sleep_for(timing.configure);
+        localStream(output) << "Playing movie: " + movie + "\n" << std::flush;
+    }
+
+    void off() {
+        std::this_thread::sleep_for(timing.off);
+        localStream(output) << "DVD Player is OFF.\n" << std::flush;
+    }
+};
+
+// Subsystem class: Projector
+class Projector {
+private:
+    DeviceTiming timing;
+    std::ostream& output;
+
+public:
+    Projector(DeviceTiming times = {}, std::ostream& out = eventStream()) : timing(times), output(out) {}
+
+    void on() {
+        std::this_thread::sleep_for(timing.on);
+        localStream(output) << "Projector is ON.\n" << std::flush;
+    }
+
+    void setWideScreenMode() {
+        std::this_thread::sleep_for(timing.configure);
+        localStream(output) << "Projector set to widescreen mode.\n" << std::flush;
+    }
+
+    void off() {
+        std::this_thread::sleep_for(timing.off);
+        localStream(output) << "Projector is OFF.\n" << std::flush;
+    }
+};
+
+// Subsystem class: Sound System
+class SoundSystem {
+private:
+    DeviceTiming timing;
+    std::ostream& output;
+
+public:
+    SoundSystem(DeviceTiming times = {}, std::ostream& out = eventStream()) : timing(times), output(out) {}
+
+    void on() {
+        std::this_thread::sleep_for(timing.on);
+        localStream(output) << "Sound System is ON.\n" << std::flush;
+    }
+
+    void setSurroundSound() {
+        std::this_thread::sleep_for(timing.configure);
+        localStream(output) << "Sound System set to surround sound.\n" << std::flush;
+    }
+
+    void off() {
+        std::this_thread::sleep_for(timing.off);
+        localStream(output) << "Sound System is OFF.\n" << std::flush;
+    }
+};
+
+// Timing of one run of a SceneOrchestrator
+struct SceneReport {
+    struct StepTiming {
+        std::string name;
+        double startMs;
+        double durationMs;
+    };
+
+    std::vector<StepTiming> steps;  // In the order they were added
+    double wallMs = 0;  // End-to-end time of the run
+    double sequentialMs = 0;  // Sum of all step durations: what running them one after another would cost
+    double criticalPathMs = 0;  // Longest chain of dependent steps
+    std::vector<std::string> criticalPath;  // Names of the steps on that chain, first to last
+};
+
+// Runs named steps as soon as the steps they depend on have finished, so independent steps overlap.
+// A step can only depend on steps added before it, which rules out cycles by construction.
+class SceneOrchestrator {
+public:
+    using StepId = std::size_t;
+
+private:
+    struct Step {
+        std::string name;
+        std::function<void()> action;
+        std::vector<StepId> dependencies;
+    };
+
+    std::vector<Step> steps;
+
+public:
+    StepId addStep(std::string name, std::function<void()> action, std::vector<StepId> dependsOn = {}) {
+        for (StepId dependency : dependsOn) {
+            if (dependency >= steps.size()) {
+                throw std::invalid_argument("step " + name + " depends on a step that has not been added");
+            }
+        }
+        steps.push_back(Step{std::move(name), std::move(action), std::move(dependsOn)});
+        return steps.size() - 1;
+    }
+
+    // Run every step, each on its own thread once its dependencies are done. If a step throws, the steps that
+    // depend on it are skipped and the first exception is rethrown after all started steps have finished.
+    SceneReport run() const {
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point begin = Clock::now();
+        std::vector<std::shared_future<void>> done;
+        std::vector<SceneReport::StepTiming> timings(steps.size());
+        done.reserve(steps.size());
+        for (StepId id = 0; id < steps.size(); ++id) {
+            std::vector<std::shared_future<void>> waitFor;
+            for (StepId dependency : steps[id].dependencies) {
+                waitFor.push_back(done[dependency]);
+            }
+            done.push_back(std::async(std::launch::async, [this, id, begin, &timings, waitFor = std::move(waitFor)] {
+                for (const std::shared_future<void>& dependency : waitFor) {
+                    dependency.get();  // Rethrows a dependency's failure, which skips this step
+                }
+                Clock::time_point start = Clock::now();
+                steps[id].action();
+                timings[id] = SceneReport::StepTiming{steps[id].name,
+                    std::chrono::duration<double, std::milli>(start - begin).count(),
+                    std::chrono::duration<double, std::milli>(Clock::now() - start).count()};
+            }).share());
+        }
+
+        std::exception_ptr failure;
+        for (const std::shared_future<void>& step : done) {
+            try {
+                step.get();
+            } catch (...) {
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+            }
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+
+        // Longest path through the dependency graph, weighted by the measured step durations
+        SceneReport report;
+        report.wallMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+        std::vector<double> chainMs(steps.size());
+        std::vector<StepId> previous(steps.size(), steps.size());
+        StepId last = 0;
+        for (StepId id = 0; id < steps.size(); ++id) {
+            for (StepId dependency : steps[id].dependencies) {
+                if (chainMs[dependency] > chainMs[id]) {
+                    chainMs[id] = chainMs[dependency];
+                    previous[id] = dependency;
+                }
+            }
+            chainMs[id] += timings[id].durationMs;
+            report.sequentialMs += timings[id].durationMs;
+            if (chainMs[id] > chainMs[last]) {
+                last = id;
+            }
+        }
+        if (!steps.empty()) {
+            report.criticalPathMs = chainMs[last];
+            for (StepId id = last; id != steps.size(); id = previous[id]) {
+                report.criticalPath.insert(report.criticalPath.begin(), steps[id].name);
+            }
+        }
+        report.steps = std::move(timings);
+        return report;
+    }
+};
+
+// The Facade class: Home Theater Facade
+class HomeTheaterFacade {
+private:
+    DVDPlayer* dvdPlayer;
+    Projector* projector;
+    SoundSystem* soundSystem;
+
+public:
+    HomeTheaterFacade(DVDPlayer* dvd, Projector* proj, SoundSystem* sound)
+        : dvdPlayer(dvd), projector(proj), soundSystem(sound) {}
+
+    // Simplified method to watch a movie
+    void watchMovie(const std::string& movie) {
+        logEvent<LogLevel::Info>("Setting up the home theater to watch a movie...");
+        projector->on();
+        projector->setWideScreenMode();
+
+        soundSystem->on();
+        soundSystem->setSurroundSound();
+
+        dvdPlayer->on();
+        dvdPlayer->play(movie);
+    }
+
+    // Simplified method to end the movie
+    void endMovie() {
+        logEvent<LogLevel::Info>("Shutting down the home theater...");
+        dvdPlayer->off();
+        soundSystem->off();
+        projector->off();
+    }
+
+    // Same scene as watchMovie(), with the three devices warming up concurrently; the movie starts once the
+    // projector and the sound system are configured and the DVD player is on
+    SceneReport watchMovieAsync(const std::string& movie) {
+        SceneOrchestrator scene;
+        auto projectorOn = scene.addStep("projector on", [this] { projector->on(); });
+        auto wideScreen = scene.addStep("widescreen", [this] { projector->setWideScreenMode(); }, {projectorOn});
+        auto soundOn = scene.addStep("sound on", [this] { soundSystem->on(); });
+        auto surround = scene.addStep("surround", [this] { soundSystem->setSurroundSound(); }, {soundOn});
+        auto dvdOn = scene.addStep("dvd on", [this] { dvdPlayer->on(); });
+        scene.addStep("play", [this, movie] { dvdPlayer->play(movie); }, {wideScreen, surround, dvdOn});
+        return scene.run();
+    }
+
+    // Same as endMovie(): the DVD player stops first, then the projector and sound system power off together
+    SceneReport endMovieAsync() {
+        SceneOrchestrator scene;
+        auto dvdOff = scene.addStep("dvd off", [this] { dvdPlayer->off(); });
+        scene.addStep("sound off", [this] { soundSystem->off(); }, {dvdOff});
+        scene.addStep("projector off", [this] { projector->off(); }, {dvdOff});
+        return scene.run();
+    }
+};
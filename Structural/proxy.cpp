@@ -57,59 +57,257 @@ Summary:
 The Proxy pattern provides a surrogate or placeholder for another object to control access to it,
 useful for scenarios where resource management, lazy loading, or access control is important.
 
+Shared Image Cache:
+ProxyImage loads on the first display(), so that call blocks, and it keeps its RealImage for as long as the proxy
+lives. CachedProxyImage instead borrows the image from a shared ImageCache on each display():
+- The cache charges every image its byteSize() and keeps entries in least-recently-used order; when the total goes
+  over the byte budget, the oldest entries are evicted. A proxy holds the image only while it is being displayed.
+  An image larger than the whole budget is returned without being cached (counted in Stats::uncached).
+- A hit returns the cached pointer directly; futures exist only for loads in flight.
+- prefetch(filenames) queues loads on the cache's background threads and returns a std::shared_future per file,
+  so a gallery can load the next page while the current one is shown.
+- A file that is already loading is not loaded again: every caller, foreground or prefetch, waits on the same future.
+- A failed load is not cached; its exception is passed to everyone waiting on that future.
+
+Thread-Safe Lazy Loading:
+ProxyImage's "if (!realImage) realImage = ..." inside the const display() is a data race when render threads share
+one proxy: two threads can both load the file, and one of the images leaks. ConcurrentProxyImage keeps an atomic
+state, Unloaded -> Loading -> Ready. The thread that moves it to Loading does the load, and the others park with
+std::atomic::wait until the state changes instead of spinning. Once the state is Ready, image() and display() cost
+one acquire load. If the load throws, the state goes back to Unloaded and a waiting thread retries. MutexProxyImage
+(a mutex on every call) is the baseline in the contention benchmark.
+
+Memory-Mapped Images:
+RealImage(file, AccessPattern) loads a real pixel file (PixelFileHeader, then rows of pixels). The whole file is
+mapped read-only with mmap instead of being read into a heap buffer:
+- The constructor reads only the header. pixels() is a std::span straight into the mapping, and each page is read
+  from disk the first time it is touched.
+- AccessPattern becomes an madvise hint. Sequential reads ahead for full passes. Random turns read-ahead off, so
+  sparse access pulls in little more than the pages it uses.
+- region(x, y, w, h, rowStep) describes a tile, or every rowStep-th row of one, as row spans without reading
+  anything. prefetch(region) issues MADV_WILLNEED for just those rows. A thumbnail of a 200 MB image therefore faults
+  in only the rows it samples.
+The simulated constructors are unchanged. Their pixels() views a buffer the image owns.
+
 */
-#include <iostream>
-#include <memory>
-#include <string>
+#include "proxy.h"
 
-// Subject interface (common interface between RealImage and Proxy)
-class Image {
-public:
-    virtual void display() const = 0;  // Abstract display method
-    virtual ~Image() = default;
-};
+#include <chrono>
+#include <filesystem>
+#include <iostream>
 
-// RealSubject: Represents the actual large image that is costly to load
-class RealImage : public Image {
+// Baseline for the contention benchmark: the same lazy load guarded by a mutex on every call
+class MutexProxyImage : public Image {
 private:
     std::string filename;
-
-    // Method to load the image from disk (expensive operation)
-    void loadImageFromDisk() const {
-        std::cout << "Loading image from disk: " << filename << std::endl;
-    }
+    std::size_t bytes;
+    std::ostream& output;
+    mutable std::mutex mutex;
+    mutable std::unique_ptr<RealImage> realImage;
 
 public:
-    // Constructor which "loads" the image (simulated)
-    RealImage(const std::string& file) : filename(file) {
-        loadImageFromDisk();  // Simulate loading the image during construction
+    MutexProxyImage(const std::string& file, std::size_t imageBytes = 0, std::ostream& out = eventStream())
+        : filename(file), bytes(imageBytes), output(out) {}
+
+    const RealImage& image() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!realImage) {
+            realImage = std::make_unique<RealImage>(filename, bytes, output);
+        }
+        return *realImage;
     }
 
-    // Display the image (after it's loaded)
     void display() const override {
-        std::cout << "Displaying image: " << filename << std::endl;
+        image().display();
     }
 };
 
-// Proxy: Controls access to the RealImage
-class ProxyImage : public Image {
-private:
-    std::string filename;
-    mutable std::unique_ptr<RealImage> realImage;  // Delayed initialization of RealImage
+// 32 threads call image() on one shared proxy and on one proxy each; also checks that a shared proxy loaded once
+template <typename Proxy>
+void measureProxyContention(const char* label, bool shared) {
+    const int threadCount = 32;
+    const int callsPerThread = 200'000;
+    std::vector<std::unique_ptr<std::ostream>> sinks;  // One discarding stream per proxy, so loads do not share one
+    std::vector<std::unique_ptr<Proxy>> proxies;
+    for (int i = 0; i < (shared ? 1 : threadCount); ++i) {
+        sinks.push_back(std::make_unique<std::ostream>(nullptr));
+        proxies.push_back(std::make_unique<Proxy>("frame_" + std::to_string(i) + ".png", 0, *sinks.back()));
+    }
 
-public:
-    // Constructor with the filename
-    ProxyImage(const std::string& file) : filename(file), realImage(nullptr) {}
+    std::vector<const RealImage*> seen(threadCount, nullptr);
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            const Proxy& proxy = *proxies[shared ? 0 : t];
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            std::size_t checksum = 0;
+            for (int i = 0; i < callsPerThread; ++i) {
+                checksum += proxy.image().byteSize();
+            }
+            seen[t] = checksum ? &proxy.image() : nullptr;
+        });
+    }
+    auto begin = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
 
-    // Display the image (load it if it's not already loaded)
-    void display() const override {
-        if (!realImage) {
-            // If the real image is not loaded yet, load it
-            realImage = std::make_unique<RealImage>(filename);
+    bool loadedOnce = !shared || std::all_of(seen.begin(), seen.end(), [&](const RealImage* image) { return image == seen[0]; });
+    std::cout << label << (shared ? " same proxy:      " : " separate proxies: ") << ns / (double(threadCount) * callsPerThread)
+              << " ns/call" << (loadedOnce ? "" : "  (LOADED MORE THAN ONCE)") << '\n';
+}
+
+void runProxyContentionBenchmark() {
+    std::cout << "\nLazy proxy contention, 32 threads (" << std::thread::hardware_concurrency() << " hardware threads):\n";
+    for (bool shared : {true, false}) {
+        measureProxyContention<ConcurrentProxyImage>("atomic state,", shared);
+        measureProxyContention<MutexProxyImage>("mutex,       ", shared);
+    }
+}
+
+// Gallery scroll: each page shows 8 images. Without prefetch every first paint waits for the load; with prefetch the
+// next page loads in the background while the current one is on screen.
+void runGalleryBenchmark() {
+    const std::size_t imageBytes = 4 * 1024 * 1024;
+    const auto loadLatency = std::chrono::milliseconds(5);
+    const auto viewTime = std::chrono::milliseconds(25);
+    const int pages = 8;
+    const int perPage = 8;
+    std::ostream sink(nullptr);  // Discards the load and display messages
+
+    std::atomic<int> loads{0};
+    auto slowLoader = [&](const std::string& filename) {
+        loads.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::sleep_for(loadLatency);
+        return std::make_shared<const RealImage>(filename, imageBytes, sink);
+    };
+    auto pageFiles = [&](int page) {
+        std::vector<std::string> files;
+        for (int i = 0; i < perPage; ++i) {
+            files.push_back("gallery_" + std::to_string(page * perPage + i) + ".jpg");
         }
-        realImage->display();  // Delegate the display call to RealImage
+        return files;
+    };
+
+    std::cout << "\nGallery of " << pages * perPage << " images of " << imageBytes / (1024 * 1024) << " MiB, "
+              << loadLatency.count() << " ms per load, 16-image budget:\n";
+    for (bool usePrefetch : {false, true}) {
+        ImageCache cache(16 * imageBytes + 16 * 1024, 2, slowLoader);
+        double firstPaintMs = 0;
+        for (int page = 0; page < pages; ++page) {
+            if (usePrefetch && page + 1 < pages) {
+                cache.prefetch(pageFiles(page + 1));
+            }
+            for (const std::string& file : pageFiles(page)) {
+                auto begin = std::chrono::steady_clock::now();
+                CachedProxyImage(file, cache).display();
+                firstPaintMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            }
+            std::this_thread::sleep_for(viewTime);
+        }
+        ImageCache::Stats stats = cache.getStats();
+        std::cout << (usePrefetch ? "prefetch next page: " : "load on display:    ") << firstPaintMs / (pages * perPage)
+                  << " ms avg first paint, peak " << stats.peakResidentBytes / (1024 * 1024) << " MiB cached, "
+                  << stats.evictions << " evictions\n";
     }
-};
+
+    // Many threads asking for the same uncached file share one load
+    loads = 0;
+    ImageCache cache(64 * imageBytes, 2, slowLoader);
+    std::vector<std::thread> viewers;
+    for (int i = 0; i < 16; ++i) {
+        viewers.emplace_back([&cache] { cache.acquire("shared.jpg"); });
+    }
+    for (std::thread& viewer : viewers) {
+        viewer.join();
+    }
+    std::cout << "16 concurrent requests for one file: " << loads.load() << " load(s)\n";
+}
+
+// Evict a file's pages from the page cache so the next read comes from disk
+void dropPageCache(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+}
+
+// Bytes of a span currently in the page cache (what a pass actually pulled in from disk)
+std::size_t residentBytes(std::span<const std::uint8_t> bytes) {
+    const std::size_t pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    auto first = reinterpret_cast<std::uintptr_t>(bytes.data()) / pageSize * pageSize;
+    std::size_t length = reinterpret_cast<std::uintptr_t>(bytes.data()) + bytes.size() - first;
+    std::vector<unsigned char> pages((length + pageSize - 1) / pageSize);
+    if (::mincore(reinterpret_cast<void*>(first), length, pages.data()) != 0) {
+        return 0;
+    }
+    return static_cast<std::size_t>(std::count_if(pages.begin(), pages.end(), [](unsigned char page) { return page & 1; })) * pageSize;
+}
+
+// Reads a large pixel file three ways, each from a cold and then a warm page cache: read() into a heap buffer,
+// a full pass over the mapped pixels, and a 1-in-16-rows thumbnail pass over the mapping
+void runImageIoBenchmark() {
+    const std::uint32_t side = 7168;  // 7168 x 7168 x 4 bytes, about 196 MiB
+    const std::string path = (std::filesystem::temp_directory_path() / "proxy_large_image.pix").string();
+    writePixelFile(path, side, side);
+    std::ostream sink(nullptr);
+    auto ms = [](auto begin) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    };
+
+    std::cout << "\nReading a " << std::filesystem::file_size(path) / (1024 * 1024) << " MiB image (cold, then warm page cache):\n";
+    for (bool cold : {true, false}) {
+        if (cold) {
+            dropPageCache(path);
+        }
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<std::uint8_t> copy(std::filesystem::file_size(path));
+        std::ifstream in(path, std::ios::binary);
+        in.read(reinterpret_cast<char*>(copy.data()), static_cast<std::streamsize>(copy.size()));
+        std::uint64_t sum = 0;
+        for (std::uint8_t byte : std::span(copy).subspan(sizeof(PixelFileHeader))) {
+            sum += byte;
+        }
+        std::cout << (cold ? "cold" : "warm") << " read() copy:     " << ms(begin) << " ms (sum " << sum << ")\n";
+    }
+    for (bool cold : {true, false}) {
+        if (cold) {
+            dropPageCache(path);
+        }
+        auto begin = std::chrono::steady_clock::now();
+        RealImage image(path, AccessPattern::Sequential, sink);
+        std::uint64_t sum = 0;
+        for (std::uint8_t byte : image.pixels()) {
+            sum += byte;
+        }
+        std::cout << (cold ? "cold" : "warm") << " mmap full pass: " << ms(begin) << " ms (sum " << sum << ")\n";
+    }
+    for (bool cold : {true, false}) {
+        if (cold) {
+            dropPageCache(path);
+        }
+        auto begin = std::chrono::steady_clock::now();
+        RealImage image(path, AccessPattern::Random, sink);
+        ImageRegion thumbnail = image.region(0, 0, side, side, 16);
+        std::uint64_t sum = 0;
+        for (std::size_t r = 0; r < thumbnail.rows; ++r) {
+            std::span<const std::uint8_t> row = thumbnail.row(r);
+            for (std::size_t px = 0; px < row.size(); px += 16 * 4) {
+                sum += row[px];
+            }
+        }
+        std::cout << (cold ? "cold" : "warm") << " mmap thumbnail: " << ms(begin) << " ms (sum " << sum << "), "
+                  << residentBytes(image.pixels()) / (1024 * 1024) << " MiB of the file in page cache\n";
+    }
+    std::filesystem::remove(path);
+}
 
 // Client code
 int main() {
@@ -117,12 +315,53 @@ int main() {
     std::unique_ptr<Image> image = std::make_unique<ProxyImage>("high_resolution_image.jpg");
 
     // First display (this will trigger the real image to load)
-    std::cout << "First display:\n";
+    logEvent<LogLevel::Info>("First display:");
     image->display();
 
     // Second display (the image is already loaded, so no need to load it again)
-    std::cout << "\nSecond display:\n";
+    logEvent<LogLevel::Info>("\nSecond display:");
     image->display();
 
+    // Proxies sharing a byte-budgeted cache; the second file is prefetched in the background
+    ImageCache cache(64 * 1024 * 1024);
+    CachedProxyImage first("holiday.jpg", cache);
+    CachedProxyImage second("panorama.jpg", cache);
+    logEvent<LogLevel::Info>("\nCached proxies:");
+    auto pending = cache.prefetch({"panorama.jpg"});
+    first.display();
+    pending.front().wait();
+    second.display();
+    second.display();
+
+    // A proxy shared by several render threads loads its image exactly once
+    ConcurrentProxyImage sharedImage("shared_banner.png");
+    logEvent<LogLevel::Info>("\nConcurrent proxy:");
+    std::vector<std::thread> renderers;
+    for (int i = 0; i < 4; ++i) {
+        renderers.emplace_back([&sharedImage] { sharedImage.image(); });
+    }
+    for (std::thread& renderer : renderers) {
+        renderer.join();
+    }
+    sharedImage.display();
+
+    // File-backed image: the pixels are viewed in the mapping, and only the tile that is read gets faulted in
+    const std::string tilePath = (std::filesystem::temp_directory_path() / "proxy_demo_image.pix").string();
+    writePixelFile(tilePath, 256, 256);
+    {
+        RealImage mapped(tilePath, AccessPattern::Random);
+        ImageRegion tile = mapped.region(64, 64, 32, 32);
+        mapped.prefetch(tile);
+        mapped.display();
+        logEvent<LogLevel::Info>(mapped.getWidth(), "x", mapped.getHeight(), " image, tile of ", tile.rows, " rows of ",
+                                 tile.rowBytes, " bytes, first byte ", int(tile.row(0)[0]));
+    }
+    std::filesystem::remove(tilePath);
+
+    flushEvents();  // The benchmarks print to std::cout directly
+    runGalleryBenchmark();
+    runProxyContentionBenchmark();
+    runImageIoBenchmark();
+
     return 0;
 }
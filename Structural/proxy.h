@@ -0,0 +1,522 @@
+// Proxy pattern classes. proxy.cpp explains the pattern and runs the examples and benchmarks.
+#pragma once
+
+#include "instrumentation.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Subject interface (common interface between RealImage and Proxy)
+class Image {
+public:
+    virtual void display() const = 0;  // Abstract display method
+    virtual ~Image() = default;
+};
+
+// Access hints passed to the kernel for a mapped image
+enum class AccessPattern { Normal, Sequential, Random };
+
+// Read-only memory mapping of a whole file; pages are read from disk only when first touched
+class FileMapping {
+private:
+    const std::uint8_t* base = nullptr;
+    std::size_t length = 0;
+
+    static int adviceFor(AccessPattern pattern) {
+        switch (pattern) {
+            case AccessPattern::Sequential: return MADV_SEQUENTIAL;
+            case AccessPattern::Random: return MADV_RANDOM;
+            default: return MADV_NORMAL;
+        }
+    }
+
+public:
+    explicit FileMapping(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot open image " + path);
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+            int error = info.st_size == 0 ? EINVAL : errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "cannot map image " + path);
+        }
+        length = static_cast<std::size_t>(info.st_size);
+        void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        int error = errno;
+        ::close(fd);  // The mapping keeps the file referenced
+        if (mapping == MAP_FAILED) {
+            throw std::system_error(error, std::generic_category(), "cannot map image " + path);
+        }
+        base = static_cast<const std::uint8_t*>(mapping);
+    }
+
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+
+    ~FileMapping() {
+        ::munmap(const_cast<std::uint8_t*>(base), length);
+    }
+
+    std::span<const std::uint8_t> bytes() const {
+        return {base, length};
+    }
+
+    // Hint how the whole mapping will be read
+    void advise(AccessPattern pattern) const {
+        ::madvise(const_cast<std::uint8_t*>(base), length, adviceFor(pattern));
+    }
+
+    // Ask the kernel to start reading [offset, offset + size) in the background
+    void willNeed(std::size_t offset, std::size_t size) const {
+        static const std::size_t pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        std::size_t first = offset / pageSize * pageSize;
+        std::size_t last = std::min(offset + size, length);
+        if (first < last) {
+            ::madvise(const_cast<std::uint8_t*>(base + first), last - first, MADV_WILLNEED);
+        }
+    }
+};
+
+// Header of the raw pixel files RealImage maps: magic "PIX1", then width, height and bytes per pixel.
+// Rows of width * bytesPerPixel bytes follow, top to bottom.
+struct PixelFileHeader {
+    char magic[4];
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t bytesPerPixel;
+};
+
+inline constexpr char kPixelFileMagic[4] = {'P', 'I', 'X', '1'};
+
+// Rectangular part of an image: row(i) is a span straight into the image's pixel storage
+struct ImageRegion {
+    const std::uint8_t* origin = nullptr;  // First byte of the first row
+    std::size_t stride = 0;  // Bytes between the starts of consecutive rows in the region
+    std::size_t rowBytes = 0;
+    std::size_t rows = 0;
+
+    std::span<const std::uint8_t> row(std::size_t index) const {
+        return {origin + index * stride, rowBytes};
+    }
+};
+
+// RealSubject: Represents the actual large image that is costly to load
+class RealImage : public Image {
+private:
+    std::string filename;
+    std::vector<std::uint8_t> ownedPixels;  // Simulated images own their pixel data
+    std::unique_ptr<const FileMapping> mapping;  // File-backed images view it in the mapping instead
+    std::span<const std::uint8_t> pixelData;
+    std::size_t width = 0;
+    std::size_t height = 0;
+    std::size_t bytesPerPixel = 1;
+    std::ostream& output;
+
+    // Method to load the image from disk (expensive operation)
+    void loadImageFromDisk() const {
+        localStream(output) << "Loading image from disk: " << filename << '\n';
+    }
+
+public:
+    // Constructor which "loads" the image (simulated)
+    RealImage(const std::string& file) : RealImage(file, 0) {}
+
+    // "Loads" an image holding `bytes` bytes of pixel data (one row of 1-byte pixels) and reports to `out`
+    RealImage(const std::string& file, std::size_t bytes, std::ostream& out = eventStream())
+        : filename(file), ownedPixels(bytes, 0x7f), pixelData(ownedPixels), width(bytes), height(bytes ? 1 : 0), output(out) {
+        loadImageFromDisk();  // Simulate loading the image during construction
+    }
+
+    // Maps a pixel file. Only the header is read here; pixel pages are faulted in as they are accessed.
+    RealImage(const std::string& file, AccessPattern pattern, std::ostream& out = eventStream())
+        : filename(file), mapping(std::make_unique<const FileMapping>(file)), output(out) {
+        std::span<const std::uint8_t> bytes = mapping->bytes();
+        PixelFileHeader header{};
+        if (bytes.size() >= sizeof(header)) {
+            std::memcpy(&header, bytes.data(), sizeof(header));
+        }
+        std::size_t payload = 0;  // Checked: a crafted header must not wrap around to a size that fits the file
+        bool overflow = __builtin_mul_overflow(std::size_t(header.width), std::size_t(header.height), &payload)
+                        || __builtin_mul_overflow(payload, std::size_t(header.bytesPerPixel), &payload);
+        if (bytes.size() < sizeof(header) || std::memcmp(header.magic, kPixelFileMagic, sizeof(kPixelFileMagic)) != 0
+            || header.bytesPerPixel == 0 || overflow || payload > bytes.size() - sizeof(header)) {
+            throw std::runtime_error("not a pixel file: " + file);
+        }
+        width = header.width;
+        height = header.height;
+        bytesPerPixel = header.bytesPerPixel;
+        pixelData = bytes.subspan(sizeof(header), payload);
+        mapping->advise(pattern);
+        loadImageFromDisk();
+    }
+
+    // Display the image (after it's loaded)
+    void display() const override {
+        static CallSite site("RealImage::display");
+        ScopedCall call(site);
+        localStream(output) << "Displaying image: " << filename << '\n';
+    }
+
+    const std::string& getFilename() const {
+        return filename;
+    }
+
+    std::size_t getWidth() const {
+        return width;
+    }
+
+    std::size_t getHeight() const {
+        return height;
+    }
+
+    // All pixel data, row-major, without a copy
+    std::span<const std::uint8_t> pixels() const {
+        return pixelData;
+    }
+
+    // Pixels [x, x + w) of every rowStep-th row in [y, y + h), clamped to the image; nothing is read yet
+    ImageRegion region(std::size_t x, std::size_t y, std::size_t w, std::size_t h, std::size_t rowStep = 1) const {
+        x = std::min(x, width);
+        y = std::min(y, height);
+        w = std::min(w, width - x);
+        h = std::min(h, height - y);
+        rowStep = std::max<std::size_t>(rowStep, 1);
+        std::size_t rowSize = width * bytesPerPixel;
+        return ImageRegion{pixelData.data() + y * rowSize + x * bytesPerPixel, rowSize * rowStep, w * bytesPerPixel,
+                           (h + rowStep - 1) / rowStep};
+    }
+
+    // Start reading a region in the background (file-backed images only), so a later pass does not block on faults
+    void prefetch(const ImageRegion& area) const {
+        if (!mapping) {
+            return;
+        }
+        for (std::size_t r = 0; r < area.rows; ++r) {
+            mapping->willNeed(static_cast<std::size_t>(area.row(r).data() - mapping->bytes().data()), area.rowBytes);
+        }
+    }
+
+    // Memory held by the loaded image, as charged against an ImageCache budget (a mapping is charged in full)
+    std::size_t byteSize() const {
+        return sizeof(RealImage) + filename.capacity() + ownedPixels.capacity() + (mapping ? mapping->bytes().size() : 0);
+    }
+};
+
+// Write a width x height pixel file with a 4-byte gradient pattern
+inline void writePixelFile(const std::string& path, std::uint32_t width, std::uint32_t height) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    PixelFileHeader header{};
+    std::memcpy(header.magic, kPixelFileMagic, sizeof(kPixelFileMagic));
+    header.width = width;
+    header.height = height;
+    header.bytesPerPixel = 4;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::vector<std::uint8_t> row(std::size_t(width) * 4);
+    for (std::uint32_t y = 0; y < height; ++y) {
+        for (std::size_t i = 0; i < row.size(); ++i) {
+            row[i] = static_cast<std::uint8_t>(i + y);
+        }
+        out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+    if (!out) {
+        throw std::runtime_error("failed to write pixel file " + path);
+    }
+}
+
+// Proxy: Controls access to the RealImage
+class ProxyImage : public Image {
+private:
+    std::string filename;
+    mutable std::unique_ptr<RealImage> realImage;  // Delayed initialization of RealImage
+
+public:
+    // Constructor with the filename
+    ProxyImage(const std::string& file) : filename(file), realImage(nullptr) {}
+
+    // Display the image (load it if it's not already loaded)
+    void display() const override {
+        if (!realImage) {
+            // If the real image is not loaded yet, load it
+            realImage = std::make_unique<RealImage>(filename);
+        }
+        realImage->display();  // Delegate the display call to RealImage
+    }
+};
+
+// Proxy that may be shared by many render threads. The first caller loads the image while the others park on an
+// atomic state (Unloaded -> Loading -> Ready); once Ready, every later call costs a single acquire load.
+class ConcurrentProxyImage : public Image {
+private:
+    enum class LoadState : std::uint8_t { Unloaded, Loading, Ready };
+
+    std::string filename;
+    std::size_t bytes;
+    std::ostream& output;
+    mutable std::atomic<LoadState> state{LoadState::Unloaded};
+    mutable std::unique_ptr<RealImage> realImage;  // Written once by the loading thread, before state becomes Ready
+
+    const RealImage& loadSlow() const {
+        for (;;) {
+            LoadState current = LoadState::Unloaded;
+            if (state.compare_exchange_strong(current, LoadState::Loading, std::memory_order_acquire)) {
+                try {
+                    realImage = std::make_unique<RealImage>(filename, bytes, output);
+                } catch (...) {
+                    state.store(LoadState::Unloaded, std::memory_order_release);
+                    state.notify_all();  // Wake the waiters so one of them can retry
+                    throw;
+                }
+                state.store(LoadState::Ready, std::memory_order_release);
+                state.notify_all();
+                return *realImage;
+            }
+            if (current == LoadState::Ready) {
+                return *realImage;
+            }
+            state.wait(LoadState::Loading, std::memory_order_acquire);  // Parks until the loader changes the state
+            if (state.load(std::memory_order_acquire) == LoadState::Ready) {
+                return *realImage;
+            }
+        }
+    }
+
+public:
+    ConcurrentProxyImage(const std::string& file, std::size_t imageBytes = 0, std::ostream& out = eventStream())
+        : filename(file), bytes(imageBytes), output(out) {}
+
+    // The loaded image, loading it on first use
+    const RealImage& image() const {
+        if (state.load(std::memory_order_acquire) == LoadState::Ready) {
+            return *realImage;
+        }
+        return loadSlow();
+    }
+
+    void display() const override {
+        image().display();
+    }
+};
+
+// Shared, byte-budgeted cache of loaded images. Entries are kept in least-recently-used order and the oldest are
+// evicted once the budget is exceeded. Concurrent requests for the same file share one load. An image larger than
+// the whole budget is handed to the callers that waited for it but not cached, so the next request loads it again.
+class ImageCache {
+public:
+    using ImagePtr = std::shared_ptr<const RealImage>;
+    using Loader = std::function<ImagePtr(const std::string&)>;
+
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;  // Loads started (one per file however many callers waited on it)
+        std::size_t evictions = 0;
+        std::size_t uncached = 0;  // Loads larger than the budget, returned without being cached
+        std::size_t residentBytes = 0;
+        std::size_t peakResidentBytes = 0;
+    };
+
+private:
+    struct Entry {
+        std::string filename;
+        ImagePtr image;
+        std::size_t bytes;
+    };
+
+    std::size_t byteBudget;
+    Loader loader;
+
+    mutable std::mutex mutex;
+    std::list<Entry> lru;  // Most recently used at the front
+    std::unordered_map<std::string, std::list<Entry>::iterator> entries;
+    std::unordered_map<std::string, std::shared_future<ImagePtr>> inFlight;
+    Stats stats;
+
+    // Background loaders for prefetch()
+    std::deque<std::function<void()>> tasks;
+    std::condition_variable tasksReady;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    static ImagePtr loadFromDisk(const std::string& filename) {
+        return std::make_shared<const RealImage>(filename);
+    }
+
+    // Insert a freshly loaded image and evict from the back until the budget holds again (caller holds the mutex)
+    void insert(const std::string& filename, ImagePtr image) {
+        std::size_t bytes = image->byteSize();
+        if (bytes > byteBudget) {
+            ++stats.uncached;  // Caching it would evict everything else and still exceed the budget
+            return;
+        }
+        lru.push_front(Entry{filename, std::move(image), bytes});
+        entries[filename] = lru.begin();
+        stats.residentBytes += bytes;
+        while (stats.residentBytes > byteBudget) {  // Stops before the new entry, which fits on its own
+            Entry& victim = lru.back();
+            stats.residentBytes -= victim.bytes;
+            entries.erase(victim.filename);
+            lru.pop_back();
+            ++stats.evictions;
+        }
+        stats.peakResidentBytes = std::max(stats.peakResidentBytes, stats.residentBytes);
+    }
+
+    // Look the file up and return the cached image. Otherwise set `pending` to the file's load, registering a new
+    // one in `load` that the caller must run with runLoad() when nobody is loading it yet.
+    ImagePtr find(const std::string& filename, std::shared_future<ImagePtr>& pending,
+                  std::shared_ptr<std::promise<ImagePtr>>& load) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (auto entry = entries.find(filename); entry != entries.end()) {
+            ++stats.hits;
+            lru.splice(lru.begin(), lru, entry->second);
+            return entry->second->image;
+        }
+        if (auto loading = inFlight.find(filename); loading != inFlight.end()) {
+            ++stats.hits;
+            pending = loading->second;
+            return nullptr;
+        }
+        ++stats.misses;
+        load = std::make_shared<std::promise<ImagePtr>>();
+        pending = load->get_future().share();
+        inFlight.emplace(filename, pending);
+        return nullptr;
+    }
+
+    void runLoad(const std::string& filename, std::promise<ImagePtr>& load) {
+        try {
+            ImagePtr image = loader(filename);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                inFlight.erase(filename);
+                insert(filename, image);
+            }
+            load.set_value(std::move(image));
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                inFlight.erase(filename);
+            }
+            load.set_exception(std::current_exception());
+        }
+    }
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            tasksReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;  // Stopping, and every queued prefetch has run
+            }
+            std::function<void()> task = std::move(tasks.front());
+            tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+public:
+    ImageCache(std::size_t budgetBytes, unsigned loaderThreads = 2, Loader load = loadFromDisk)
+        : byteBudget(budgetBytes), loader(std::move(load)) {
+        for (unsigned i = 0; i < std::max(loaderThreads, 1u); ++i) {
+            workers.emplace_back(&ImageCache::workerLoop, this);
+        }
+    }
+
+    ImageCache(const ImageCache&) = delete;
+    ImageCache& operator=(const ImageCache&) = delete;
+
+    ~ImageCache() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        tasksReady.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Return the image, loading it on the calling thread if nobody else is loading it already
+    ImagePtr acquire(const std::string& filename) {
+        std::shared_future<ImagePtr> pending;
+        std::shared_ptr<std::promise<ImagePtr>> load;
+        if (ImagePtr cached = find(filename, pending, load)) {
+            return cached;  // A hit allocates nothing
+        }
+        if (load) {
+            runLoad(filename, *load);
+        }
+        return pending.get();
+    }
+
+    // Start loading the files on the background threads; files that are cached or already loading are not reloaded
+    std::vector<std::shared_future<ImagePtr>> prefetch(const std::vector<std::string>& filenames) {
+        std::vector<std::shared_future<ImagePtr>> futures;
+        futures.reserve(filenames.size());
+        for (const std::string& filename : filenames) {
+            std::shared_future<ImagePtr> pending;
+            std::shared_ptr<std::promise<ImagePtr>> load;
+            if (ImagePtr cached = find(filename, pending, load)) {
+                std::promise<ImagePtr> ready;
+                ready.set_value(std::move(cached));
+                pending = ready.get_future().share();
+            }
+            futures.push_back(std::move(pending));
+            if (load) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    tasks.emplace_back([this, filename, load] { runLoad(filename, *load); });
+                }
+                tasksReady.notify_one();
+            }
+        }
+        return futures;
+    }
+
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+};
+
+// Proxy that borrows its image from a shared ImageCache on every display() instead of owning it, so the
+// cache's byte budget bounds how many images stay in memory
+class CachedProxyImage : public Image {
+private:
+    std::string filename;
+    ImageCache& cache;
+
+public:
+    CachedProxyImage(const std::string& file, ImageCache& imageCache) : filename(file), cache(imageCache) {}
+
+    void display() const override {
+        cache.acquire(filename)->display();
+    }
+};
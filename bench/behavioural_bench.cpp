@@ -0,0 +1,243 @@
+// Behavioural patterns: PaymentContext::processPayment, WeatherStation::notifyObservers, TCPConnection dispatch and
+// BookIterator iteration, each in its classic form next to the optimized variants
+#include "bench_support.h"
+
+#include "iterator.h"
+#include "observer.h"
+#include "state.h"
+#include "strategy.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Strategies that record the amount instead of printing, so the measurement is the dispatch itself
+class LedgerPayment final : public PaymentStrategy {
+private:
+    double* ledger;
+
+public:
+    explicit LedgerPayment(double& total) : ledger(&total) {}
+
+    void pay(float amount) const override {
+        *ledger += amount;
+    }
+};
+
+class RefundPayment final : public PaymentStrategy {
+private:
+    double* ledger;
+
+public:
+    explicit RefundPayment(double& total) : ledger(&total) {}
+
+    void pay(float amount) const override {
+        *ledger -= amount;
+    }
+};
+
+// Observer that only counts updates (no I/O), so the measurement is the notification path itself
+class CountingDisplay : public Observer {
+private:
+    std::atomic<std::uint64_t> updates{0};
+
+public:
+    using Observer::update;
+
+    void update(float) override {
+        updates.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const {
+        return updates.load(std::memory_order_relaxed);
+    }
+};
+
+// --- PaymentContext::processPayment ---
+
+void BM_Strategy_Classic(benchmark::State& state) {
+    double total = 0.0;
+    PaymentContext context;
+    context.setStrategy(std::make_shared<LedgerPayment>(total));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        context.processPayment(12.5f);
+    }
+    benchmark::DoNotOptimize(total);
+}
+BENCHMARK(BM_Strategy_Classic);
+
+void BM_Strategy_Static(benchmark::State& state) {
+    double total = 0.0;
+    StaticPaymentContext<LedgerPayment> context{LedgerPayment(total)};
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        context.processPayment(12.5f);
+        benchmark::ClobberMemory();
+    }
+    benchmark::DoNotOptimize(total);
+}
+BENCHMARK(BM_Strategy_Static);
+
+void BM_Strategy_Variant(benchmark::State& state) {
+    double total = 0.0;
+    VariantPaymentContext<LedgerPayment, RefundPayment> context{LedgerPayment(total)};
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        context.processPayment(12.5f);
+        benchmark::ClobberMemory();
+    }
+    benchmark::DoNotOptimize(total);
+}
+BENCHMARK(BM_Strategy_Variant);
+
+// --- WeatherStation::notifyObservers, range(0) observers per notification ---
+
+template <typename Station>
+void BM_Observer_Notify(benchmark::State& state) {
+    Station station;
+    std::vector<std::shared_ptr<CountingDisplay>> displays;
+    for (int i = 0; i < state.range(0); ++i) {
+        displays.push_back(std::make_shared<CountingDisplay>());
+        station.addObserver(displays.back());
+    }
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        station.notifyObservers();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_Observer_Notify, WeatherStation)->ArgName("observers")->Arg(1)->Arg(16)->Arg(256);
+BENCHMARK_TEMPLATE(BM_Observer_Notify, ConcurrentWeatherStation)->ArgName("observers")->Arg(1)->Arg(16)->Arg(256);
+
+// --- TCPConnection dispatch: one open / receive / send / close cycle per iteration ---
+
+// The classic states: one shared_ptr<State> per transition and a logged event per call
+void BM_State_Classic(benchmark::State& state) {
+    TCPConnection connection(std::make_shared<ClosedState>());
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        connection.open();
+        connection.setState(std::make_shared<ListeningState>());
+        connection.receiveData("SYN");
+        connection.setState(std::make_shared<EstablishedState>());
+        connection.sendData("payload");
+        connection.close();
+        connection.setState(std::make_shared<ClosedState>());
+    }
+}
+BENCHMARK(BM_State_Classic);
+
+// Same events through the transition table, still logging each message
+void BM_State_TableHandle(benchmark::State& state) {
+    TableTCPConnection connection;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        connection.open();
+        connection.receiveData("SYN");
+        connection.sendData("payload");
+        connection.close();
+    }
+}
+BENCHMARK(BM_State_TableHandle);
+
+// Table lookups only, the caller decides what to do with each Transition
+void BM_State_TableStep(benchmark::State& state) {
+    TableTCPConnection connection;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(&connection.step(ConnectionEvent::Open));
+        benchmark::DoNotOptimize(&connection.step(ConnectionEvent::ReceiveData));
+        benchmark::DoNotOptimize(&connection.step(ConnectionEvent::SendData));
+        benchmark::DoNotOptimize(&connection.step(ConnectionEvent::Close));
+    }
+}
+BENCHMARK(BM_State_TableStep);
+
+// --- BookIterator over range(0) books; items/s is books visited per second ---
+
+std::string titleOf(std::int64_t i) {
+    return "Title " + std::to_string(i);
+}
+
+std::string authorOf(std::int64_t i) {
+    return "Author " + std::to_string(i % 1000);
+}
+
+void BM_Iterator_Classic(benchmark::State& state) {
+    Library library;
+    for (std::int64_t i = 0; i < state.range(0); ++i) {
+        library.addBook(titleOf(i), authorOf(i));
+    }
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::size_t characters = 0;
+        auto iterator = library.createIterator();
+        while (iterator->hasNext()) {
+            characters += iterator->next()->getTitle().size();
+        }
+        benchmark::DoNotOptimize(characters);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Iterator_Classic)->Arg(100'000);
+
+void BM_Iterator_Compact(benchmark::State& state) {
+    CompactLibrary library;
+    for (std::int64_t i = 0; i < state.range(0); ++i) {
+        library.addBook(titleOf(i), authorOf(i));
+    }
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::size_t characters = 0;
+        for (BookView book : library) {
+            characters += book.getTitle().size();
+        }
+        benchmark::DoNotOptimize(characters);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Iterator_Compact)->Arg(100'000);
+
+// One author's books: a full scan against the author index
+void BM_Iterator_AuthorScan(benchmark::State& state) {
+    Library library;
+    for (std::int64_t i = 0; i < state.range(0); ++i) {
+        library.addBook(titleOf(i), authorOf(i));
+    }
+    const std::string author = authorOf(42);
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::size_t found = 0;
+        auto iterator = library.createIterator();
+        while (iterator->hasNext()) {
+            found += iterator->next()->getAuthor() == author;
+        }
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(BM_Iterator_AuthorScan)->Arg(100'000);
+
+void BM_Iterator_AuthorIndex(benchmark::State& state) {
+    Library library;
+    for (std::int64_t i = 0; i < state.range(0); ++i) {
+        library.addBook(titleOf(i), authorOf(i));
+    }
+    const std::string author = authorOf(42);
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::size_t found = 0;
+        auto iterator = library.createIterator(AuthorFilter{author});
+        while (iterator->hasNext()) {
+            found += iterator->next() != nullptr;
+        }
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(BM_Iterator_AuthorIndex)->Arg(100'000);
+
+}  // namespace
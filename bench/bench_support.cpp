@@ -0,0 +1,10 @@
+#include "bench_support.h"
+
+#include "instrumentation.h"
+
+#include <memory>
+
+namespace {
+// Events are still formatted into the per-thread rings, but the drain thread throws them away
+const bool eventsDiscarded = (EventLog::instance().setSink(std::make_shared<DiscardEventSink>()), true);
+}
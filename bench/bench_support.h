@@ -0,0 +1,31 @@
+// Shared helpers for pattern_bench: a heap allocation counter reported per iteration. bench_support.cpp also sends
+// the pattern classes' events to a DiscardEventSink, so the numbers include logging the event but not printing it.
+#pragma once
+
+#include "counting_allocator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+
+// Reports the allocations made while it is alive as the "allocs/iter" counter. Construct it right before the
+// benchmark loop so setup is not counted; in multi-threaded runs only thread 0 reports, covering every thread.
+class AllocationCounter {
+private:
+    benchmark::State& state;
+    std::size_t start;
+
+public:
+    explicit AllocationCounter(benchmark::State& benchmarkState)
+        : state(benchmarkState), start(heapAllocationCount()) {}
+
+    ~AllocationCounter() {
+        if (state.thread_index() == 0) {
+            double allocations = static_cast<double>(heapAllocationCount() - start);
+            state.counters["allocs/iter"] = benchmark::Counter(allocations, benchmark::Counter::kAvgIterations);
+        }
+    }
+
+    AllocationCounter(const AllocationCounter&) = delete;
+    AllocationCounter& operator=(const AllocationCounter&) = delete;
+};
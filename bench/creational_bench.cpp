@@ -0,0 +1,154 @@
+// Creational patterns: Singleton::getInstance, VehicleFactory::createVehicle and Shape::clone, each in its classic
+// form next to the optimized variants
+#include "bench_support.h"
+
+#include "factory.h"
+#include "prototype.h"
+#include "singleton.h"
+
+#include <memory>
+#include <memory_resource>
+
+namespace {
+
+// --- Singleton::getInstance ---
+
+void BM_Singleton_Classic(benchmark::State& state) {
+    Singleton::getInstance();  // Creates the instance outside the timed loop
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Singleton::getInstance());
+    }
+}
+BENCHMARK(BM_Singleton_Classic);
+
+template <typename Accessor>
+void BM_Singleton(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        Accessor::getInstance();  // The other threads wait at the start of the loop
+    }
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Accessor::getInstance());
+    }
+}
+BENCHMARK_TEMPLATE(BM_Singleton, MeyersSingleton<Config>)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(BM_Singleton, AtomicSingleton<Config>)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(BM_Singleton, MutexSingleton<Config>)->ThreadRange(1, 8);
+
+// Writes through the singleton: one shared counter against per-thread and sharded instances
+template <typename Accessor>
+void BM_SingletonRecord(benchmark::State& state) {
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Accessor::getInstance()->record();
+    }
+}
+BENCHMARK_TEMPLATE(BM_SingletonRecord, AtomicSingleton<HitCounter>)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(BM_SingletonRecord, ThreadLocalSingleton<HitCounter>)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(BM_SingletonRecord, ShardedSingleton<HitCounter, 64>)->ThreadRange(1, 8);
+
+// --- VehicleFactory::createVehicle ---
+
+void BM_Factory_Classic(benchmark::State& state) {
+    CarFactory carFactory;
+    const VehicleFactory& factory = carFactory;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::unique_ptr<Vehicle> vehicle = factory.createVehicle();
+        benchmark::DoNotOptimize(vehicle.get());
+    }
+}
+BENCHMARK(BM_Factory_Classic);
+
+void BM_Factory_PoolResource(benchmark::State& state) {
+    CarFactory carFactory;
+    const VehicleFactory& factory = carFactory;
+    std::pmr::unsynchronized_pool_resource pool;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        PooledVehicle vehicle = factory.createVehicle(&pool);
+        benchmark::DoNotOptimize(vehicle.get());
+    }
+}
+BENCHMARK(BM_Factory_PoolResource);
+
+// One VehicleBlock per iteration; items/s is vehicles created per second
+void BM_Factory_Block(benchmark::State& state) {
+    CarFactory carFactory;
+    const VehicleFactory& factory = carFactory;
+    std::pmr::unsynchronized_pool_resource pool;
+    auto count = static_cast<std::size_t>(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        VehicleBlock block = factory.createVehicles(count, &pool);
+        benchmark::DoNotOptimize(&block[0]);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Factory_Block)->Arg(64)->Arg(1024);
+
+void BM_Factory_StaticTable(benchmark::State& state) {
+    std::size_t tag = VehicleTable::tagOf<Car>();
+    benchmark::DoNotOptimize(tag);
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        VehicleTable::Product vehicle = VehicleTable::create(tag);
+        benchmark::DoNotOptimize(vehicle);
+    }
+}
+BENCHMARK(BM_Factory_StaticTable);
+
+// --- Shape::clone ---
+
+void BM_Prototype_Classic(benchmark::State& state) {
+    Circle circle(10, "Red");
+    const Shape& prototype = circle;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::unique_ptr<Shape> clone = prototype.clone();
+        benchmark::DoNotOptimize(clone.get());
+    }
+}
+BENCHMARK(BM_Prototype_Classic);
+
+void BM_Prototype_CopyOnWrite(benchmark::State& state) {
+    CowCircle circle(10, "Red");
+    const Shape& prototype = circle;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::unique_ptr<Shape> clone = prototype.clone();
+        benchmark::DoNotOptimize(clone.get());
+    }
+}
+BENCHMARK(BM_Prototype_CopyOnWrite);
+
+// n clones into a fresh ShapePool per iteration; items/s is clones per second
+template <typename Concrete>
+void BM_Prototype_CloneN(benchmark::State& state) {
+    Concrete circle(10, "Red");
+    const Shape& prototype = circle;
+    auto count = static_cast<std::size_t>(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        ShapePool pool(count * sizeof(Concrete));
+        prototype.cloneN(count, pool);
+        benchmark::DoNotOptimize(&pool);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_Prototype_CloneN, Circle)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_Prototype_CloneN, CowCircle)->Arg(1024);
+
+void BM_Prototype_Registry(benchmark::State& state) {
+    PrototypeRegistry registry;
+    PrototypeId id = registry.add(CompactCircle(10, registry.colors().intern("Red"), registry.colors()));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::unique_ptr<Shape> clone = registry.clone(id);
+        benchmark::DoNotOptimize(clone.get());
+    }
+}
+BENCHMARK(BM_Prototype_Registry);
+
+}  // namespace
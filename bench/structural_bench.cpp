@@ -0,0 +1,150 @@
+// Structural patterns: decorator cost(), ProxyImage::display and AudioPlayer::playAudio, each in its classic form
+// next to the optimized variants
+#include "bench_support.h"
+
+#include "adapter.h"
+#include "decorator.h"
+#include "proxy.h"
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace {
+
+// --- Decorator cost() and getDescription() over ten add-ons ---
+
+// Milk, Sugar, Milk, Sugar ... around a SimpleCoffee, built with the caching decorators
+std::unique_ptr<Coffee> cachedChain() {
+    std::unique_ptr<Coffee> chain = std::make_unique<SimpleCoffee>();
+    for (int layer = 0; layer < 5; ++layer) {
+        chain = std::make_unique<MilkDecorator>(std::move(chain));
+        chain = std::make_unique<SugarDecorator>(std::move(chain));
+    }
+    return chain;
+}
+
+// The same order with the original decorator, which walks the whole chain on every call
+std::unique_ptr<Coffee> recomputingChain() {
+    std::unique_ptr<Coffee> chain = std::make_unique<SimpleCoffee>();
+    for (int layer = 0; layer < 5; ++layer) {
+        chain = std::make_unique<RecomputingDecorator>(std::move(chain), "Milk", 1.0);
+        chain = std::make_unique<RecomputingDecorator>(std::move(chain), "Sugar", 0.5);
+    }
+    return chain;
+}
+
+using ComposedCoffee = Decorated<SimpleCoffee, Milk, Sugar, Milk, Sugar, Milk, Sugar, Milk, Sugar, Milk, Sugar>;
+
+enum class Order { Recomputing, Cached, Flattened, Composed };
+
+std::unique_ptr<Coffee> makeOrder(Order order) {
+    switch (order) {
+        case Order::Recomputing: return recomputingChain();
+        case Order::Cached: return cachedChain();
+        case Order::Flattened: return flatten(*cachedChain());
+        case Order::Composed: return std::make_unique<ComposedCoffee>();
+    }
+    return nullptr;
+}
+
+void BM_Decorator_Cost(benchmark::State& state) {
+    std::unique_ptr<Coffee> coffee = makeOrder(static_cast<Order>(state.range(0)));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(coffee->cost());
+    }
+}
+
+void BM_Decorator_Description(benchmark::State& state) {
+    std::unique_ptr<Coffee> coffee = makeOrder(static_cast<Order>(state.range(0)));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::string description = coffee->getDescription();
+        benchmark::DoNotOptimize(description.data());
+    }
+}
+
+void orderArguments(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgName("order");  // 0 recomputing (classic), 1 cached, 2 flattened, 3 Decorated<>
+    for (int order = 0; order <= static_cast<int>(Order::Composed); ++order) {
+        benchmark->Arg(order);
+    }
+}
+BENCHMARK(BM_Decorator_Cost)->Apply(orderArguments);
+BENCHMARK(BM_Decorator_Description)->Apply(orderArguments);
+
+// --- ProxyImage::display once the image is loaded ---
+
+void BM_Proxy_Classic(benchmark::State& state) {
+    ProxyImage image("photo.jpg");
+    image.display();
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        image.display();
+    }
+}
+BENCHMARK(BM_Proxy_Classic);
+
+void BM_Proxy_Concurrent(benchmark::State& state) {
+    static std::ostream sink(nullptr);
+    static ConcurrentProxyImage image("photo.jpg", 0, sink);  // Shared by all benchmark threads
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        image.display();
+    }
+}
+BENCHMARK(BM_Proxy_Concurrent)->ThreadRange(1, 8);
+
+void BM_Proxy_Cached(benchmark::State& state) {
+    std::ostream sink(nullptr);
+    ImageCache cache(1024 * 1024, 1, [&sink](const std::string& filename) {
+        return std::make_shared<const RealImage>(filename, 0, sink);
+    });
+    CachedProxyImage image("photo.jpg", cache);
+    image.display();
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        image.display();
+    }
+}
+BENCHMARK(BM_Proxy_Cached);
+
+// --- AudioPlayer::playAudio ---
+
+const std::string mediaTypes[] = {"mp3", "mp4", "avi"};
+
+template <typename Player>
+void BM_Adapter_PlayAudio(benchmark::State& state) {
+    std::ostream sink(nullptr);
+    Player player(sink);
+    MediaPlayer& media = player;
+    const std::string& type = mediaTypes[state.range(0)];
+    const std::string fileName = "clip." + type;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        media.playAudio(type, fileName);
+    }
+}
+
+void formatArguments(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgName("format")->Arg(0)->Arg(1)->Arg(2);  // mp3, mp4, avi
+}
+BENCHMARK_TEMPLATE(BM_Adapter_PlayAudio, PerCallAudioPlayer)->Apply(formatArguments);
+BENCHMARK_TEMPLATE(BM_Adapter_PlayAudio, AudioPlayer)->Apply(formatArguments);
+
+// The enum overload skips parsing the type string
+void BM_Adapter_PlayFormat(benchmark::State& state) {
+    std::ostream sink(nullptr);
+    AudioPlayer player(sink);
+    MediaPlayer& media = player;
+    MediaFormat format = parseFormat(mediaTypes[state.range(0)]);
+    const std::string fileName = "clip." + mediaTypes[state.range(0)];
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        media.play(format, fileName);
+    }
+}
+BENCHMARK(BM_Adapter_PlayFormat)->Apply(formatArguments);
+
+}  // namespace